@@ -0,0 +1,375 @@
+//<-----------------Description Section----------------------->
+// Test for vl_format: the format string parser on every kind of
+// placeholder and on every malformed string it must reject (the vector
+// is then left as it was), integers in every base and floats in every
+// style against std::to_chars, round trips through vl_parse_int /
+// vl_parse_float, and the parsers at inner positions, with counts and
+// on every error. Each output is appended after 0 to PREFIX_MAX chars
+// already in a vector with a small static capacity, so the text lands
+// in the inline buffer, across its end, and in a grown heap block.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.
+//       tests/vl_format_test.cpp -o format_test && ./format_test
+
+#include "vl_format.hpp"
+#include "vl_string.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define PREFIX_MAX 20
+
+static long g_checks = 0;
+static std::mt19937_64 g_rng (42);
+
+static void check (bool ok, const char *what, std::string_view input,
+                   size_t pos)
+{
+  ++g_checks;
+  if (!ok)
+  {
+    std::fprintf (stderr, "FAILED: %s, input \"%.*s\", position %zu\n",
+                  what, (int) input.size (), input.data (), pos);
+    std::exit (1);
+  }
+}
+
+using text = vl_vector<char, 8>;
+
+static std::string_view view (const text &t)
+{
+  return std::string_view (t.data (), t.size ());
+}
+
+static text make_prefix (size_t len)
+{
+  text t;
+  for (size_t i = 0; i < len; ++i)
+  {
+    t.push_back ((char) ('a' + i % 26));
+  }
+  return t;
+}
+
+//<--------Format strings---------->
+// fmt with args must give want, after every prefix length
+template<typename... Args>
+static void expect (std::string_view want, std::string_view fmt,
+                    const Args &...args)
+{
+  for (size_t len = 0; len <= PREFIX_MAX; ++len)
+  {
+    text t = make_prefix (len);
+    std::string full (view (t));
+    full += want;
+    vl_append_format (t, fmt, args...);
+    check (view (t) == full, "vl_append_format", fmt, len);
+  }
+}
+
+// fmt with args must throw std::invalid_argument and change nothing
+template<typename... Args>
+static void expect_error (std::string_view fmt, const Args &...args)
+{
+  for (size_t len = 0; len <= PREFIX_MAX; len += 7)
+  {
+    text t = make_prefix (len);
+    std::string before (view (t));
+    bool thrown = false;
+    try
+    {
+      vl_append_format (t, fmt, args...);
+    }
+    catch (const std::invalid_argument &)
+    {
+      thrown = true;
+    }
+    check (thrown && view (t) == before, "vl_append_format error", fmt,
+           len);
+  }
+}
+
+static void test_format ()
+{
+  expect ("", "");
+  expect ("plain text, no placeholders", "plain text, no placeholders");
+  expect ("{", "{{");
+  expect ("}", "}}");
+  expect ("{}", "{{}}");
+  expect ("a{b}c", "a{{b}}c");
+  expect ("{42}", "{{{}}}", 42);
+  expect ("42", "{}", 42);
+  expect ("x=42 y=3.14", "x={} y={:.2f}", 42, 3.14159);
+  expect ("-7-7", "{}{}", -7, (int64_t) -7);
+  expect ("ff FF? 11111111 377 255", "{:x} FF? {:b} {:o} {:d}", 255,
+          (uint8_t) 255, 255u, (short) 255);
+  expect ("-80000000", "{:x}", std::numeric_limits<int32_t>::min ());
+  expect ("18446744073709551615", "{}",
+          std::numeric_limits<uint64_t>::max ());
+  expect ("0.1 0.1", "{} {}", 0.1, 0.1f);
+  expect ("1.5e+00 1.500e+00", "{:e} {:.3e}", 1.5, 1.5);
+  expect ("1235 1.235e+04", "{:.4g} {:.4g}", 1234.6, 12346.0);
+  expect ("1p+0 1.8p+1", "{:a} {:a}", 1.0, 3.0);
+  expect ("-0 inf -inf nan", "{} {} {} {}", -0.0,
+          std::numeric_limits<double>::infinity (),
+          -std::numeric_limits<float>::infinity (),
+          std::numeric_limits<double>::quiet_NaN ());
+  expect ("c true false str view", "{} {} {} {} {}", 'c', true, false,
+          "str", std::string_view ("view"));
+  expect (std::string (100, 'x') + "|1|",
+          std::string (100, 'x') + "|{}|", 1);
+
+  expect_error ("{");
+  expect_error ("}");
+  expect_error ("a}b");
+  expect_error ("{", 1);
+  expect_error ("{:", 1);
+  expect_error ("{0}", 1);
+  expect_error ("{x}", 1);
+  expect_error ("{:.}", 1.0);
+  expect_error ("{:.-1f}", 1.0);
+  expect_error ("{:.2ff}", 1.0);
+  expect_error ("{:zz}", 1);
+  expect_error ("{:q}", 1);
+  expect_error ("{:x}", 1.0);
+  expect_error ("{:f}", 1);
+  expect_error ("{:.2f}", 1);
+  expect_error ("{:d}", "str");
+  expect_error ("{:d}", 'c');
+  expect_error ("{:x}", true);
+  expect_error ("{}");
+  expect_error ("{} {}", 1);
+  expect_error ("{}", 1, 2);
+  expect_error ("no placeholder", 1);
+  expect_error ("ok {} then {", 1, 2);
+}
+
+//<--------Numbers---------->
+template<typename T>
+static void int_round_trip (T value, int base)
+{
+  char buf[80];
+  std::to_chars_result res = std::to_chars (buf, buf + sizeof buf, value,
+                                            base);
+  std::string_view want (buf, res.ptr - buf);
+  for (size_t len = 0; len <= PREFIX_MAX; len += 3)
+  {
+    text t = make_prefix (len);
+    vl_append_int (t, value, base);
+    check (view (t).substr (len) == want, "vl_append_int", want, len);
+    size_t end = 0;
+    T back = vl_parse_int<T> (t, len, (size_t) -1, &end, base);
+    check (back == value && end == t.size (), "vl_parse_int round trip",
+           want, len);
+  }
+}
+
+template<typename T>
+static void test_int ()
+{
+  using limits = std::numeric_limits<T>;
+  for (int base = 2; base <= 36; ++base)
+  {
+    for (T value : {limits::min (), T (limits::min () + 1), T (0), T (1),
+                    T (base - 1), T (base), limits::max (),
+                    T (limits::max () - 1)})
+    {
+      int_round_trip (value, base);
+    }
+    for (int i = 0; i < 20; ++i)
+    {
+      int_round_trip (T (g_rng ()), base);
+    }
+  }
+}
+
+template<typename T>
+static T random_float ()
+{
+  using U = std::conditional_t<sizeof (T) == 4, uint32_t, uint64_t>;
+  T value;
+  do
+  {
+    U bits = (U) g_rng ();
+    std::memcpy (&value, &bits, sizeof (T));
+  } while (!std::isfinite (value));
+  return value;
+}
+
+template<typename T>
+static void float_styles (T value)
+{
+  const std::chars_format styles[] = {
+      std::chars_format::fixed, std::chars_format::scientific,
+      std::chars_format::general, std::chars_format::hex};
+  char buf[400]; // the longest: a fixed DBL_MAX or denorm_min
+  for (std::chars_format style : styles)
+  {
+    for (int precision : {-1, 0, 1, 6, 17, 40})
+    {
+      std::to_chars_result res =
+          precision < 0
+          ? std::to_chars (buf, buf + sizeof buf, value, style)
+          : std::to_chars (buf, buf + sizeof buf, value, style, precision);
+      std::string_view want (buf, res.ptr - buf);
+      text t = make_prefix ((size_t) (precision + 1) % PREFIX_MAX);
+      size_t len = t.size ();
+      vl_append_float (t, value, style, precision);
+      check (view (t).substr (len) == want, "vl_append_float with a style",
+             want, len);
+    }
+  }
+}
+
+template<typename T>
+static void test_float ()
+{
+  using limits = std::numeric_limits<T>;
+  std::vector<T> values = {T (0), T (-0.0), T (1), T (-1), T (0.1),
+                           limits::min (), limits::denorm_min (),
+                           limits::max (), limits::lowest (),
+                           limits::epsilon ()};
+  for (int i = 0; i < 300; ++i)
+  {
+    values.push_back (random_float<T> ());
+  }
+  for (T value : values)
+  {
+    for (size_t len = 0; len <= PREFIX_MAX; len += 5)
+    {
+      text t = make_prefix (len);
+      vl_append_float (t, value);
+      size_t end = 0;
+      T back = vl_parse_float<T> (t, len, (size_t) -1, &end);
+      check (std::memcmp (&back, &value, sizeof (T)) == 0
+                 && end == t.size (),
+             "vl_append_float round trip", view (t), len);
+    }
+    float_styles (value);
+  }
+}
+
+//<--------Parsing---------->
+template<typename E, typename F>
+static void expect_throw (F parse, std::string_view input, size_t pos)
+{
+  bool thrown = false;
+  try
+  {
+    parse ();
+  }
+  catch (const E &)
+  {
+    thrown = true;
+  }
+  check (thrown, "parse error", input, pos);
+}
+
+static void test_parse ()
+{
+  text t;
+  vl_append_chars (t, "ab12cd-34 +5 x");
+  std::string_view in = view (t);
+  size_t end = 0;
+  check (vl_parse_int<int> (t, 2, (size_t) -1, &end) == 12 && end == 4,
+         "vl_parse_int inside", in, 2);
+  check (vl_parse_int<int> (t, 2, 1, &end) == 1 && end == 3,
+         "vl_parse_int with a count", in, 2);
+  check (vl_parse_int<int> (t, 6, (size_t) -1, &end) == -34 && end == 9,
+         "vl_parse_int negative", in, 6);
+  check (vl_parse_int<int> (t, 3) == 2, "vl_parse_int without end", in, 3);
+  check (vl_parse_int<int> (t, 2, 4, &end, 16) == 0x12cd && end == 6,
+         "vl_parse_int in base 16", in, 2);
+
+  for (size_t pos : {0, 1, 9, 10, 13, 14})
+  {
+    expect_throw<std::invalid_argument> (
+        [&] { return vl_parse_int<int> (t, pos); }, in, pos);
+  }
+  expect_throw<std::invalid_argument> (
+      [&] { return vl_parse_int<int> (t, 2, 0); }, in, 2);
+  expect_throw<std::invalid_argument> (
+      [&] { return vl_parse_int<unsigned> (t, 6); }, in, 6);
+  expect_throw<std::out_of_range> (
+      [&] { return vl_parse_int<int> (t, 15); }, in, 15);
+
+  text big;
+  vl_append_chars (big, "300 -129 99999999999999999999 1e400 1e-400");
+  std::string_view b = view (big);
+  check (vl_parse_int<uint8_t> (big, 0, 2) == 30, "count stops early", b,
+         0);
+  expect_throw<std::out_of_range> (
+      [&] { return vl_parse_int<uint8_t> (big, 0); }, b, 0);
+  expect_throw<std::out_of_range> (
+      [&] { return vl_parse_int<int8_t> (big, 4); }, b, 4);
+  expect_throw<std::out_of_range> (
+      [&] { return vl_parse_int<int64_t> (big, 9); }, b, 9);
+  expect_throw<std::out_of_range> (
+      [&] { return vl_parse_float<double> (big, 30); }, b, 30);
+  expect_throw<std::out_of_range> (
+      [&] { return vl_parse_float<float> (big, 36); }, b, 36);
+
+  text f;
+  vl_append_chars (f, "x=2.5e3;1p3;inf;-nan;.5;");
+  std::string_view fv = view (f);
+  check (vl_parse_float<double> (f, 2, (size_t) -1, &end) == 2500
+             && end == 7,
+         "vl_parse_float inside", fv, 2);
+  check (vl_parse_float<double> (f, 2, 3, &end) == 2.5 && end == 5,
+         "vl_parse_float with a count", fv, 2);
+  check (vl_parse_float<double> (f, 2, (size_t) -1, &end,
+                                 std::chars_format::fixed) == 2.5
+             && end == 5,
+         "vl_parse_float fixed", fv, 2);
+  check (vl_parse_float<float> (f, 8, (size_t) -1, &end,
+                                std::chars_format::hex) == 8
+             && end == 11,
+         "vl_parse_float hex", fv, 8);
+  check (std::isinf (vl_parse_float<double> (f, 12)), "inf", fv, 12);
+  check (std::isnan (vl_parse_float<double> (f, 16)), "nan", fv, 16);
+  expect_throw<std::invalid_argument> (
+      [&] { return vl_parse_float<double> (f, 0); }, fv, 0);
+  expect_throw<std::invalid_argument> (
+      [&] { return vl_parse_float<double> (f, 20); }, fv, 20);
+  check (vl_parse_float<double> (f, 21) == 0.5, "no leading zero", fv, 21);
+}
+
+// the vl_string members forward to the same code
+static void test_string ()
+{
+  vl_string s ("id=");
+  s.append_format ("{} t={:.3f}", 7, 0.5);
+  check (s == "id=7 t=0.500", "vl_string::append_format", "", 0);
+  check (s.parse_int<int> (3) == 7 && s.parse_float<double> (7) == 0.5,
+         "vl_string::parse_int / parse_float", "", 0);
+}
+
+int main ()
+{
+  test_format ();
+  std::printf ("vl_format strings: ok\n");
+  test_int<int8_t> ();
+  test_int<uint8_t> ();
+  test_int<int16_t> ();
+  test_int<int32_t> ();
+  test_int<uint32_t> ();
+  test_int<int64_t> ();
+  test_int<uint64_t> ();
+  test_float<float> ();
+  test_float<double> ();
+  std::printf ("vl_format numbers: ok\n");
+  test_parse ();
+  test_string ();
+  std::printf ("vl_format parsing: ok\n");
+  std::printf ("vl_format: %ld checks passed\n", g_checks);
+  return 0;
+}
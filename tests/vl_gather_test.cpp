@@ -0,0 +1,291 @@
+//<-----------------Description Section----------------------->
+// Test for the vl_gather kernels on inputs of every length from 0 to
+// MAX_LEN, so every case lands at the start, middle and end of the 4, 8
+// and 16 lane blocks, the 64 element mask words and the scalar tails.
+// Every element width (1, 2, 4 and 8 bytes, integer and floating point)
+// runs with every index width, and each check runs with the dispatchers
+// limited to the scalar loops, to AVX2 and to AVX-512F in turn (when the
+// CPU has them), against simple reference loops.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.
+//       tests/vl_gather_test.cpp -o gather_test && ./gather_test
+
+#include "vl_gather.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#define MAX_LEN 150
+
+enum mode
+{
+  SCALAR, AVX2, AVX512
+};
+
+static const char *mode_names[] = {"scalar", "avx2", "avx512"};
+static mode g_mode = SCALAR;
+static long g_checks = 0;
+static std::mt19937 g_rng (42);
+
+static void check (bool ok, const char *what, size_t n, size_t pos)
+{
+  ++g_checks;
+  if (!ok)
+  {
+    std::fprintf (stderr, "FAILED (%s): %s, length %zu, position %zu\n",
+                  mode_names[g_mode], what, n, pos);
+    std::exit (1);
+  }
+}
+
+//<--------Inputs---------->
+// distinct values for any length up to MAX_LEN, negative ones included
+template<typename T>
+static T value (size_t i)
+{
+  return std::is_signed<T>::value ? T ((long) (i % 250) - 125) : T (i % 250);
+}
+
+template<typename T>
+static std::vector<T> make_source (size_t n)
+{
+  std::vector<T> src (n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    src[i] = value<T> (i);
+  }
+  return src;
+}
+
+// out holds a few elements already, so the results land at an offset
+template<typename T>
+static vl_vector<T, 4> make_out ()
+{
+  return vl_vector<T, 4> {value<T> (7), value<T> (9), value<T> (11)};
+}
+
+template<typename T>
+static bool same (const vl_vector<T, 4> &out, const std::vector<T> &want)
+{
+  if (out.size () != 3 + want.size () || out[0] != value<T> (7)
+      || out[1] != value<T> (9) || out[2] != value<T> (11))
+  {
+    return false;
+  }
+  for (size_t i = 0; i < want.size (); ++i)
+  {
+    if (out[3 + i] != want[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//<--------Tests---------->
+template<typename T, typename I>
+static void test_gather ()
+{
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    std::vector<T> src = make_source<T> (n + 5);
+    std::vector<I> idx (n);
+    // every index in reverse, then at random
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        idx[i] = I (pass == 0 ? src.size () - 1 - i
+                              : g_rng () % src.size ());
+      }
+      std::vector<T> want (n);
+      for (size_t i = 0; i < n; ++i)
+      {
+        want[i] = src[(size_t) idx[i]];
+      }
+      vl_vector<T, 4> out = make_out<T> ();
+      vl_gather (out, src, idx);
+      check (same (out, want), "gather", n, pass);
+    }
+  }
+}
+
+template<typename T, typename I>
+static void test_scatter ()
+{
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    std::vector<T> src = make_source<T> (n);
+    std::vector<I> idx (n);
+    // a permutation, then repeated indices where the last one wins
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      size_t size = pass == 0 ? n + 5 : n / 3 + 1;
+      for (size_t i = 0; i < n; ++i)
+      {
+        idx[i] = I (pass == 0 ? size - 1 - i : g_rng () % size);
+      }
+      std::vector<T> want (size, value<T> (1));
+      std::vector<T> dst (size, value<T> (1));
+      for (size_t i = 0; i < n; ++i)
+      {
+        want[(size_t) idx[i]] = src[i];
+      }
+      vl_scatter (dst, src, idx);
+      check (dst == want, "scatter", n, pass);
+    }
+  }
+}
+
+template<typename T>
+static std::vector<T> kept (const std::vector<T> &src,
+                            const std::vector<unsigned char> &mask)
+{
+  std::vector<T> want;
+  for (size_t i = 0; i < src.size (); ++i)
+  {
+    if (mask[i])
+    {
+      want.push_back (src[i]);
+    }
+  }
+  return want;
+}
+
+template<typename T>
+static void filter_and_compress (const std::vector<T> &src,
+                                 const std::vector<unsigned char> &mask,
+                                 size_t pos)
+{
+  size_t n = src.size ();
+  std::vector<T> want = kept (src, mask);
+  vl_vector<T, 4> out = make_out<T> ();
+  vl_filter (out, src, mask);
+  check (same (out, want), "filter", n, pos);
+
+  std::vector<uint64_t> bits ((n + 63) / 64 + 1, 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    bits[i / 64] |= (uint64_t) (mask[i] != 0) << (i % 64);
+  }
+  // bits past the end must be ignored
+  bits[n / 64] |= ~(uint64_t) 0 << (n % 64);
+  out = make_out<T> ();
+  vl_compress (out, src, bits);
+  check (same (out, want), "compress", n, pos);
+}
+
+template<typename T>
+static void test_filter ()
+{
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    std::vector<T> src = make_source<T> (n);
+    std::vector<unsigned char> mask (n);
+    // one element kept (any non-zero byte), then one element dropped
+    for (size_t pos = 0; pos < n; ++pos)
+    {
+      std::fill (mask.begin (), mask.end (), 0);
+      mask[pos] = (unsigned char) (1 + pos % 255);
+      filter_and_compress (src, mask, pos);
+      std::fill (mask.begin (), mask.end (), 1);
+      mask[pos] = 0;
+      filter_and_compress (src, mask, pos);
+    }
+    // none, all, and a few random masks
+    std::fill (mask.begin (), mask.end (), 0);
+    filter_and_compress (src, mask, n);
+    std::fill (mask.begin (), mask.end (), 0xFF);
+    filter_and_compress (src, mask, n);
+    for (int pass = 0; pass < 4; ++pass)
+    {
+      for (size_t i = 0; i < n; ++i)
+      {
+        mask[i] = g_rng () % 2;
+      }
+      filter_and_compress (src, mask, n);
+    }
+  }
+}
+
+template<typename T>
+static void test_select ()
+{
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    std::vector<T> src = make_source<T> (n);
+    std::shuffle (src.begin (), src.end (), g_rng);
+    T limit = value<T> (n / 2);
+    auto pred = [limit] (T x) { return x < limit; };
+    std::vector<T> want;
+    for (T x : src)
+    {
+      if (pred (x))
+      {
+        want.push_back (x);
+      }
+    }
+    vl_vector<T, 4> out = make_out<T> ();
+    vl_select (out, src, pred);
+    check (same (out, want), "select", n, 0);
+  }
+}
+
+template<typename T>
+static void test_type ()
+{
+  test_gather<T, int32_t> ();
+  test_gather<T, uint32_t> ();
+  test_gather<T, int64_t> ();
+  test_gather<T, uint64_t> ();
+  test_gather<T, uint16_t> ();
+  test_scatter<T, int32_t> ();
+  test_scatter<T, uint32_t> ();
+  test_scatter<T, int64_t> ();
+  test_scatter<T, uint64_t> ();
+  test_scatter<T, uint16_t> ();
+  test_filter<T> ();
+  test_select<T> ();
+}
+
+static void run_all (mode m)
+{
+  g_mode = m;
+  test_type<int8_t> ();
+  test_type<int16_t> ();
+  test_type<int32_t> ();
+  test_type<uint32_t> ();
+  test_type<float> ();
+  test_type<int64_t> ();
+  test_type<uint64_t> ();
+  test_type<double> ();
+  std::printf ("vl_gather %s: ok\n", mode_names[m]);
+}
+
+int main ()
+{
+  vl_gather_set_isa (0);
+  run_all (SCALAR);
+  if (vl_gather_set_isa (1) == 1)
+  {
+    run_all (AVX2);
+  }
+  else
+  {
+    std::printf ("vl_gather avx2: skipped, the CPU has no AVX2\n");
+  }
+  if (vl_gather_set_isa (2) == 2)
+  {
+    run_all (AVX512);
+  }
+  else
+  {
+    std::printf ("vl_gather avx512: skipped, the CPU has no AVX-512F\n");
+  }
+  std::printf ("vl_gather: %ld checks passed\n", g_checks);
+  return 0;
+}
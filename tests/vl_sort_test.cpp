@@ -0,0 +1,270 @@
+//<-----------------Description Section----------------------->
+// Test for vl_sort on every path it can take: the generated sorting
+// networks (all sizes up to VL_SORT_NETWORK_MAX, on every 0/1 input up
+// to 16 elements, which by the 0-1 principle proves those networks),
+// the insertion sort and std::sort sizes around them, and the radix sort
+// from VL_RADIX_SORT_MIN up for every key type, with duplicates, the
+// extreme values and -0.0 / 0.0. Every result is compared against
+// std::sort and std::stable_sort, and the stable variants element by
+// element (so equal keys must keep their input order).
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.
+//       tests/vl_sort_test.cpp -o sort_test && ./sort_test
+
+#include "vl_sort.hpp"
+#include "vl_jagged_vector.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <vector>
+
+#define MAX_SMALL (2 * VL_SORT_NETWORK_MAX)
+
+static long g_checks = 0;
+static std::mt19937_64 g_rng (42);
+
+static void check (bool ok, const char *what, size_t n, size_t pos)
+{
+  ++g_checks;
+  if (!ok)
+  {
+    std::fprintf (stderr, "FAILED: %s, length %zu, input %zu\n", what, n,
+                  pos);
+    std::exit (1);
+  }
+}
+
+// bit for bit, so -0.0 and 0.0 are told apart
+template<typename T>
+static bool same (const T *a, const std::vector<T> &b)
+{
+  return b.empty () || std::memcmp (a, b.data (), b.size () * sizeof (T))
+                           == 0;
+}
+
+//<--------Inputs---------->
+// random values over the whole range of T, or over only 'spread' values
+// (spread > 0) so that there are many equal keys
+template<typename T>
+static T random_value (uint64_t spread)
+{
+  uint64_t r = g_rng ();
+  if constexpr (std::is_floating_point<T>::value)
+  {
+    if (spread)
+    {
+      static const T small[] = {T (-0.0), T (0.0), T (-1.5), T (1.5),
+                                std::numeric_limits<T>::lowest (),
+                                std::numeric_limits<T>::max (),
+                                std::numeric_limits<T>::denorm_min (),
+                                -std::numeric_limits<T>::infinity ()};
+      return small[r % std::min<uint64_t> (spread, 8)];
+    }
+    return T ((double) (int64_t) r / 1e6);
+  }
+  else
+  {
+    if (spread)
+    {
+      // both ends of the range, and around zero
+      uint64_t k = r % spread;
+      return k % 2 ? T (std::numeric_limits<T>::max () - T (k / 2))
+                   : T (std::numeric_limits<T>::min () + T (k / 2));
+    }
+    T value;
+    std::memcpy (&value, &r, sizeof (T));
+    return value;
+  }
+}
+
+template<typename T>
+static std::vector<T> random_input (size_t n, uint64_t spread)
+{
+  std::vector<T> in (n);
+  for (T &x : in)
+  {
+    x = random_value<T> (spread);
+  }
+  return in;
+}
+
+//<--------Tests---------->
+// every 0/1 input of up to 16 elements, then random ones up to the max
+static void test_networks ()
+{
+  for (size_t n = 0; n <= VL_SORT_NETWORK_MAX; ++n)
+  {
+    uint64_t inputs = n <= 16 ? uint64_t (1) << n : 2000;
+    for (uint64_t m = 0; m < inputs; ++m)
+    {
+      uint64_t bits = n <= 16 ? m : g_rng ();
+      int x[VL_SORT_NETWORK_MAX + 1];
+      for (size_t i = 0; i < n; ++i)
+      {
+        x[i] = n <= 16 ? (int) ((bits >> i) & 1) : (int) (bits % 1000);
+        bits = n <= 16 ? bits : g_rng ();
+      }
+      vl_network_sort (x, n, std::less<int> ());
+      check (std::is_sorted (x, x + n), "sorting network", n, m);
+    }
+  }
+}
+
+template<typename T>
+static void test_small ()
+{
+  for (size_t n = 0; n <= MAX_SMALL; ++n)
+  {
+    for (uint64_t spread : {0, 3})
+    {
+      std::vector<T> in = random_input<T> (n, spread);
+      vl_vector<T, 16> v (in.begin (), in.end ());
+      std::vector<T> want = in;
+      std::sort (want.begin (), want.end ());
+      vl_sort (v);
+      check (std::equal (v.begin (), v.end (), want.begin (), want.end ()),
+             "small vl_sort", n, spread);
+
+      v = vl_vector<T, 16> (in.begin (), in.end ());
+      want = in;
+      std::stable_sort (want.begin (), want.end ());
+      vl_stable_sort (v);
+      check (same (v.data (), want), "small vl_stable_sort", n, spread);
+
+      v = vl_vector<T, 16> (in.begin (), in.end ());
+      std::sort (want.begin (), want.end (), std::greater<T> ());
+      vl_sort (v, std::greater<T> ());
+      check (std::equal (v.begin (), v.end (), want.begin (), want.end ()),
+             "small vl_sort with a comparator", n, spread);
+    }
+  }
+}
+
+template<typename T>
+static void test_radix ()
+{
+  const size_t sizes[] = {VL_RADIX_SORT_MIN - 1, VL_RADIX_SORT_MIN,
+                          VL_RADIX_SORT_MIN + 1, 5000, 70000};
+  for (size_t n : sizes)
+  {
+    for (uint64_t spread : {0, 1, 2, 8, 300})
+    {
+      std::vector<T> in = random_input<T> (n, spread);
+      vl_vector<T, 16> v (in.begin (), in.end ());
+      std::vector<T> want = in;
+      std::stable_sort (want.begin (), want.end ());
+      vl_stable_sort (v);
+      check (same (v.data (), want), "vl_stable_sort", n, spread);
+
+      v = vl_vector<T, 16> (in.begin (), in.end ());
+      vl_sort (v);
+      check (std::equal (v.begin (), v.end (), want.begin (), want.end ()),
+             "vl_sort", n, spread);
+    }
+  }
+}
+
+template<typename K>
+static void test_by_key ()
+{
+  const size_t sizes[] = {5, VL_SORT_NETWORK_MAX + 1, 500,
+                          VL_RADIX_SORT_MIN, 20000};
+  struct keyed
+  {
+    K key;
+    uint32_t seq;
+  };
+  auto key = [] (const keyed &r) { return r.key; };
+  auto by_key = [] (const keyed &a, const keyed &b)
+  {
+    return a.key < b.key;
+  };
+  for (size_t n : sizes)
+  {
+    for (uint64_t spread : {0, 8})
+    {
+      std::vector<keyed> in (n);
+      for (size_t i = 0; i < n; ++i)
+      {
+        in[i] = keyed {random_value<K> (spread), (uint32_t) i};
+      }
+      std::vector<keyed> want = in;
+      std::stable_sort (want.begin (), want.end (), by_key);
+      vl_vector<keyed, 16> v (in.begin (), in.end ());
+      vl_stable_sort_by_key (v, key);
+      check (same (v.data (), want), "vl_stable_sort_by_key", n, spread);
+
+      v = vl_vector<keyed, 16> (in.begin (), in.end ());
+      vl_sort_by_key (v, key);
+      bool ok = std::is_sorted (v.begin (), v.end (), by_key);
+      std::vector<uint32_t> seqs;
+      for (const keyed &r : v)
+      {
+        seqs.push_back (r.seq);
+      }
+      std::sort (seqs.begin (), seqs.end ());
+      for (size_t i = 0; i < n; ++i)
+      {
+        ok = ok && seqs[i] == i;
+      }
+      check (ok, "vl_sort_by_key", n, spread);
+    }
+  }
+}
+
+static void test_rows ()
+{
+  vl_jagged_vector<int> jag;
+  std::vector<int> row = random_input<int> (VL_RADIX_SORT_MIN * 2, 0);
+  std::vector<int> small = random_input<int> (10, 0);
+  jag.push_row (small.begin (), small.end ());
+  jag.push_row (row.begin (), row.end ());
+  jag.push_row (small.begin (), small.end ());
+  vl_sort (jag[1]);
+  std::sort (row.begin (), row.end ());
+  check (same (jag[1].data (), row), "vl_sort of a row", row.size (), 1);
+  check (same (jag[0].data (), small) && same (jag[2].data (), small),
+         "vl_sort of a row leaves the other rows alone", small.size (), 0);
+  vl_stable_sort (jag[0], std::greater<int> ());
+  std::stable_sort (small.begin (), small.end (), std::greater<int> ());
+  check (same (jag[0].data (), small), "vl_stable_sort of a row",
+         small.size (), 0);
+}
+
+template<typename T>
+static void test_type ()
+{
+  test_small<T> ();
+  test_radix<T> ();
+}
+
+int main ()
+{
+  test_networks ();
+  std::printf ("vl_sort networks: ok\n");
+  test_type<int8_t> ();
+  test_type<uint8_t> ();
+  test_type<int16_t> ();
+  test_type<uint16_t> ();
+  test_type<int32_t> ();
+  test_type<uint32_t> ();
+  test_type<int64_t> ();
+  test_type<uint64_t> ();
+  test_type<float> ();
+  test_type<double> ();
+  std::printf ("vl_sort radix: ok\n");
+  test_by_key<int32_t> ();
+  test_by_key<uint16_t> ();
+  test_by_key<float> ();
+  test_by_key<double> ();
+  test_rows ();
+  std::printf ("vl_sort by key and rows: ok\n");
+  std::printf ("vl_sort: %ld checks passed\n", g_checks);
+  return 0;
+}
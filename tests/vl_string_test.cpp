@@ -0,0 +1,355 @@
+//<-----------------Description Section----------------------->
+// Test for the vl_string kernels on buffers of every length from 0 to
+// MAX_LEN, with the match (or the bad byte) at every position, so every
+// case lands at the start, middle and end of the 16 and 32 byte blocks
+// and in the scalar tails. Each check runs three times: on the scalar
+// kernels, on the dispatchers with AVX2 forced off (SSE2) and with AVX2
+// forced on (when the CPU has it), against std::string_view and simple
+// reference loops.
+//
+// Build and run from the repository root:
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I.
+//       tests/vl_string_test.cpp -o string_test && ./string_test
+
+#include "vl_string.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#define MAX_LEN 100
+
+enum mode
+{
+  SCALAR, SSE2, AVX2
+};
+
+static const char *mode_names[] = {"scalar", "sse2", "avx2"};
+static mode g_mode = SCALAR;
+static long g_checks = 0;
+
+static void check (bool ok, const char *what, size_t n, size_t pos)
+{
+  ++g_checks;
+  if (!ok)
+  {
+    std::fprintf (stderr, "FAILED (%s): %s, length %zu, position %zu\n",
+                  mode_names[g_mode], what, n, pos);
+    std::exit (1);
+  }
+}
+
+//<--------Kernels of the current mode---------->
+static size_t find_char (const char *p, size_t n, char c)
+{
+  return g_mode == SCALAR ? vl_str_find_char_scalar (p, n, c)
+                          : vl_str_find_char (p, n, c);
+}
+
+static size_t find (const char *p, size_t n, const char *s, size_t m)
+{
+  if (g_mode == SCALAR)
+  {
+    size_t at = std::string_view (p, n).find (std::string_view (s, m));
+    return at == std::string_view::npos ? n : at;
+  }
+  return vl_str_find (p, n, s, m);
+}
+
+static size_t find_first_of (const char *p, size_t n, const char *set,
+                             size_t k)
+{
+  return g_mode == SCALAR ? vl_str_find_first_of_scalar (p, n, set, k)
+                          : vl_str_find_first_of (p, n, set, k);
+}
+
+static void ascii_case (char *p, size_t n, char lo, char hi, char delta)
+{
+  if (g_mode == SCALAR)
+  {
+    vl_str_ascii_case_scalar (p, n, lo, hi, delta);
+  }
+  else
+  {
+    vl_str_ascii_case (p, n, lo, hi, delta);
+  }
+}
+
+static bool utf8_valid (const char *p, size_t n)
+{
+  return g_mode == SCALAR ? vl_str_utf8_valid_scalar (p, n)
+                          : vl_str_utf8_valid (p, n);
+}
+
+static size_t npos_to_n (size_t at, size_t n)
+{
+  return at == std::string_view::npos ? n : at;
+}
+
+//<--------Tests---------->
+static void test_find_char ()
+{
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    for (size_t pos = 0; pos <= n; ++pos) // pos == n: no match
+    {
+      std::string s (n, 'a');
+      if (pos < n)
+      {
+        s[pos] = 'z';
+      }
+      if (pos + 7 < n)
+      {
+        s[pos + 7] = 'z'; // a later match must not win
+      }
+      check (find_char (s.data (), n, 'z') == pos, "find char", n, pos);
+      check (find_char (s.data (), n, '\0') == n, "find absent char", n,
+             pos);
+      if (g_mode != SCALAR)
+      {
+        vl_string<16> v (s);
+        for (size_t from = 0; from <= n; from += 5)
+        {
+          check (v.find ('z', from) == std::string_view (s).find ('z', from),
+                 "vl_string::find (char, pos)", n, pos);
+        }
+      }
+    }
+  }
+}
+
+static void test_find_substr ()
+{
+  // haystacks over a 3 letter alphabet: many candidates whose first and
+  // last chars match but the middle does not
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    std::string hay (n, 'a');
+    unsigned x = 12345;
+    for (char &c: hay)
+    {
+      x = x * 1103515245 + 12345;
+      c = "abc"[(x >> 16) % 3];
+    }
+    for (size_t m = 1; m <= 40 && m <= n + 1; ++m)
+    {
+      for (size_t pos = 0; pos + m <= n; ++pos)
+      {
+        std::string needle = hay.substr (pos, m);
+        size_t want = npos_to_n (std::string_view (hay).find (needle), n);
+        check (find (hay.data (), n, needle.data (), m) == want,
+               "find substring", n, pos);
+        needle[m / 2] = 'd'; // never in the haystack
+        check (find (hay.data (), n, needle.data (), m) == n,
+               "find absent substring", n, pos);
+      }
+      if (g_mode != SCALAR)
+      {
+        vl_string<16> v (hay);
+        std::string needle = hay.substr (n / 2, std::min (m, n - n / 2));
+        for (size_t from = 0; from <= n + 1; from += 7)
+        {
+          check (v.find (std::string_view (needle), from)
+                 == std::string_view (hay).find (needle, from),
+                 "vl_string::find (string_view, pos)", n, from);
+        }
+      }
+    }
+  }
+}
+
+static void test_find_first_of ()
+{
+  const std::string sets[] = {"xyz", "0123456789ABCDEF", // up to 16: SIMD
+                              "0123456789ABCDEFG"}; // 17: the fallback
+  for (const std::string &set: sets)
+  {
+    for (size_t n = 0; n <= MAX_LEN; ++n)
+    {
+      for (size_t pos = 0; pos <= n; ++pos)
+      {
+        std::string s (n, 'a');
+        if (pos < n)
+        {
+          s[pos] = set[pos % set.size ()];
+        }
+        check (find_first_of (s.data (), n, set.data (), set.size ()) == pos,
+               "find_first_of", n, pos);
+        if (g_mode != SCALAR)
+        {
+          vl_string<16> v (s);
+          check (v.find_first_of (set)
+                 == std::string_view (s).find_first_of (set),
+                 "vl_string::find_first_of", n, pos);
+        }
+      }
+    }
+  }
+}
+
+static void test_split ()
+{
+  if (g_mode == SCALAR)
+  {
+    return; // split only goes through the dispatchers
+  }
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    for (size_t pos = 0; pos <= n; ++pos)
+    {
+      std::string s (n, 'a');
+      for (size_t i = pos; i < n; i += 1 + i % 13) // delimiters from pos on
+      {
+        s[i] = ',';
+      }
+      std::vector<std::string_view> want;
+      size_t start = 0;
+      for (size_t i = 0; i <= n; ++i)
+      {
+        if (i == n || s[i] == ',')
+        {
+          want.push_back (std::string_view (s).substr (start, i - start));
+          start = i + 1;
+        }
+      }
+      vl_string<16> v (s);
+      vl_vector<std::string_view> got = v.split (',');
+      check (got.size () == want.size (), "split count", n, pos);
+      for (size_t i = 0; i < want.size (); ++i)
+      {
+        check (got[i] == want[i], "split piece", n, pos);
+      }
+    }
+  }
+}
+
+static void test_ascii_case ()
+{
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    for (size_t shift = 0; shift < 256; shift += 37) // every byte value
+    {
+      std::string s (n, '\0');
+      for (size_t i = 0; i < n; ++i)
+      {
+        s[i] = (char) ((i * 7 + shift) & 0xFF);
+      }
+      std::string lower = s, upper = s, want_lower = s, want_upper = s;
+      for (char &c: want_lower)
+      {
+        c = c >= 'A' && c <= 'Z' ? (char) (c + 32) : c;
+      }
+      for (char &c: want_upper)
+      {
+        c = c >= 'a' && c <= 'z' ? (char) (c - 32) : c;
+      }
+      ascii_case (lower.data (), n, 'A', 'Z', 'a' - 'A');
+      ascii_case (upper.data (), n, 'a', 'z', (char) ('A' - 'a'));
+      check (lower == want_lower, "to lower", n, shift);
+      check (upper == want_upper, "to upper", n, shift);
+      if (g_mode != SCALAR)
+      {
+        vl_string<16> v (s);
+        check (v.to_lower ().view () == want_lower, "vl_string::to_lower",
+               n, shift);
+        check (v.to_upper ().view () == want_upper, "vl_string::to_upper",
+               n, shift);
+      }
+    }
+  }
+}
+
+static void test_utf8 ()
+{
+  struct sequence
+  {
+    const char *bytes;
+    bool valid;
+  };
+  const sequence sequences[] = {
+      {"\xC2\x80", true}, {"\xDF\xBF", true}, // 2 bytes
+      {"\xE0\xA0\x80", true}, {"\xE2\x82\xAC", true}, // 3 bytes
+      {"\xED\x9F\xBF", true}, {"\xEF\xBF\xBF", true},
+      {"\xF0\x90\x80\x80", true}, {"\xF4\x8F\xBF\xBF", true}, // 4 bytes
+      {"\x80", false}, {"\xBF", false}, // lone continuation
+      {"\xC0\x80", false}, {"\xC1\xBF", false}, // overlong 2 bytes
+      {"\xE0\x80\x80", false}, {"\xE0\x9F\xBF", false}, // overlong 3 bytes
+      {"\xF0\x80\x80\x80", false}, {"\xF0\x8F\xBF\xBF", false}, // overlong
+      {"\xED\xA0\x80", false}, {"\xED\xBF\xBF", false}, // surrogates
+      {"\xF4\x90\x80\x80", false}, {"\xF5\x80\x80\x80", false}, // > 10FFFF
+      {"\xFF", false}, {"\xC2\x41", false}, // bad continuation
+      {"\xE2\x82\x41", false}, {"\xF0\x90\x80\x41", false},
+  };
+  for (const sequence &seq: sequences)
+  {
+    size_t len = std::char_traits<char>::length (seq.bytes);
+    for (size_t n = 0; n <= MAX_LEN; ++n)
+    {
+      for (size_t pos = 0; pos < n; ++pos)
+      {
+        std::string s (n, 'a');
+        size_t fit = std::min (len, n - pos); // cut off at the end
+        s.replace (pos, fit, seq.bytes, fit);
+        bool want = seq.valid && fit == len;
+        check (utf8_valid (s.data (), n) == want, "utf8 sequence", n, pos);
+        if (g_mode != SCALAR)
+        {
+          check (vl_string<16> (s).is_valid_utf8 () == want,
+                 "vl_string::is_valid_utf8", n, pos);
+        }
+      }
+    }
+  }
+  // long runs of multibyte chars, with one bad byte at every position
+  for (size_t n = 0; n <= MAX_LEN; ++n)
+  {
+    std::string s;
+    while (s.size () + 3 <= n)
+    {
+      s += "\xE2\x82\xAC";
+    }
+    s.append (n - s.size (), 'a');
+    check (utf8_valid (s.data (), n), "utf8 run", n, 0);
+    for (size_t pos = 0; pos < n; ++pos)
+    {
+      std::string bad = s;
+      bad[pos] = '\xFF';
+      check (!utf8_valid (bad.data (), n), "utf8 run with a bad byte", n,
+             pos);
+    }
+  }
+}
+
+static void run_all (mode m)
+{
+  g_mode = m;
+  test_find_char ();
+  test_find_substr ();
+  test_find_first_of ();
+  test_split ();
+  test_ascii_case ();
+  test_utf8 ();
+  std::printf ("vl_string %s: ok\n", mode_names[m]);
+}
+
+int main ()
+{
+  run_all (SCALAR);
+#if defined(VL_STRING_X86)
+  vl_str_set_avx2 (false);
+  run_all (SSE2);
+  if (vl_str_set_avx2 (true))
+  {
+    run_all (AVX2);
+  }
+  else
+  {
+    std::printf ("vl_string avx2: skipped, the CPU has no AVX2\n");
+  }
+#else
+  run_all (SSE2); // the dispatchers use the scalar kernels
+#endif
+  std::printf ("vl_string: %ld checks passed\n", g_checks);
+  return 0;
+}
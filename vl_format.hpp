@@ -0,0 +1,417 @@
+//<-----------------Description Section----------------------->
+// This header contains numeric formatting and parsing for char vectors
+// (any vl_vector<char, N>, and vl_string through its members), without a
+// temporary std::string per number: the number is written by
+// std::to_chars straight into the unused tail of the buffer, and then the
+// size is fixed with set_size(). As long as the text fits in the static
+// capacity, building a log line or a key does not allocate at all.
+
+//--------Formatting-----------//
+// vl_append_int(out, v, base)            - an integer.
+// vl_append_float(out, v)                - the shortest text that reads
+//                                          back to the same value.
+// vl_append_float(out, v, fmt, prec)     - fixed / scientific / general /
+//                                          hex, with a precision.
+// vl_append_format(out, "x={} y={:.2f}", x, y)
+//                                        - std::format-like placeholders.
+// Each call grows the vector at most once for integers and shortest
+// floats: when the free tail is too short, it reserves the worst case
+// width for the type before writing.
+
+//--------Format String-----------//
+// "{}" is replaced by the next argument, "{{" and "}}" are literal
+// braces. After a colon, integers take a base (b, o, d, x) and floats a
+// precision and a style ({:.3f}, {:e}, {:.4g}, {:a}). Strings, chars and
+// bools take no spec. A malformed format string, or a count of arguments
+// that does not match the placeholders, throws std::invalid_argument
+// and leaves the vector as it was.
+
+//--------Parsing-----------//
+// vl_parse_int / vl_parse_float read a number with std::from_chars at
+// any position of the buffer, like std::stoi: no leading white space or
+// '+' is skipped, std::invalid_argument is thrown if there is no number
+// and std::out_of_range if it does not fit the type.
+
+#ifndef _VL_FORMAT_HPP_
+#define _VL_FORMAT_HPP_
+
+//<------------------DEFINE & INCLUDES--------------------->
+#include "vl_vector.hpp"
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+//<-----------------------IMPLEMENTATION----------------------->
+
+//<--------Helpers---------->
+/** * vl_append_chars() - Appends the chars of s, growing at most once.
+      Runtime complexity: O(n).
+  */
+inline void vl_append_chars (vl_vector_ref<char> &out, std::string_view s)
+{
+  size_t old_size = out.size ();
+  out.reserve_more (s.size ());
+  if (!s.empty ())
+  {
+    std::memcpy (out.data () + old_size, s.data (), s.size ());
+  }
+  out.set_size (old_size + s.size ());
+}
+
+/** * vl_append_to_chars() - Runs write(first, last) on the free tail of
+      out and keeps the chars it wrote. If the tail is too short, reserves
+      width more chars and tries again (doubling width each time).
+      write returns a std::to_chars_result.
+  */
+template<class Writer>
+void vl_append_to_chars (vl_vector_ref<char> &out, size_t width, Writer write)
+{
+  size_t old_size = out.size ();
+  while (true)
+  {
+    std::to_chars_result res = write (out.data () + old_size,
+                                      out.data () + out.capacity ());
+    if (res.ec == std::errc ())
+    {
+      out.set_size (res.ptr - out.data ());
+      return;
+    }
+    out.reserve_more (width);
+    width *= 2;
+  }
+}
+
+/** * vl_int_width() - The longest text of a T in the given base,
+      sign included. Below base 10, a signed minimum needs digits + 1
+      digits (digits does not count the sign bit) plus the '-'.
+  */
+template<typename T>
+constexpr size_t vl_int_width (int base) noexcept
+{
+  return base >= 10 ? std::numeric_limits<T>::digits10 + 2
+                    : std::numeric_limits<T>::digits
+                          + (std::is_signed<T>::value ? 2 : 0);
+}
+
+/** * vl_float_width() - The longest shortest-round-trip text of a T:
+      sign, max_digits10 digits, point, and a signed exponent.
+  */
+template<typename T>
+constexpr size_t vl_float_width () noexcept
+{
+  return std::numeric_limits<T>::max_digits10 + 8;
+}
+
+//<--------Formatting---------->
+/** * vl_append_int() - Appends value written in base (2 to 36).
+      Runtime complexity: O(number of digits).
+  */
+template<typename T>
+void vl_append_int (vl_vector_ref<char> &out, T value, int base = 10)
+{
+  static_assert (std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                 "vl_append_int needs an integer type");
+  vl_append_to_chars (out, vl_int_width<T> (base),
+                      [value, base] (char *first, char *last)
+                      {
+                        return std::to_chars (first, last, value, base);
+                      });
+}
+
+/** * vl_append_float() - Appends the shortest text that reads back
+      (with vl_parse_float) to exactly value.
+      Runtime complexity: O(number of digits).
+  */
+template<typename T>
+void vl_append_float (vl_vector_ref<char> &out, T value)
+{
+  static_assert (std::is_floating_point<T>::value,
+                 "vl_append_float needs a floating point type");
+  vl_append_to_chars (out, vl_float_width<T> (),
+                      [value] (char *first, char *last)
+                      {
+                        return std::to_chars (first, last, value);
+                      });
+}
+
+/** * vl_append_float() - Appends value in the given format, with
+      precision digits (a negative precision means the shortest
+      round-trip text in that format).
+      Runtime complexity: O(number of digits).
+  */
+template<typename T>
+void vl_append_float (vl_vector_ref<char> &out, T value,
+                      std::chars_format fmt, int precision = -1)
+{
+  static_assert (std::is_floating_point<T>::value,
+                 "vl_append_float needs a floating point type");
+  size_t width = vl_float_width<T> () + (precision > 0 ? precision : 0);
+  vl_append_to_chars (out, width,
+                      [value, fmt, precision] (char *first, char *last)
+                      {
+                        return precision < 0
+                               ? std::to_chars (first, last, value, fmt)
+                               : std::to_chars (first, last, value, fmt,
+                                                precision);
+                      });
+}
+
+/**
+ * vl_format_spec - What follows the colon in a placeholder.
+ */
+struct vl_format_spec
+{
+  int precision = -1; // floats, -1 for the shortest text
+  char type = 0; // b, o, d, x for integers, f, e, g, a for floats
+};
+
+/** * vl_format_next() - Appends the literal text of fmt from pos up to
+      the next placeholder, and reads the placeholder spec.
+      return the index after the placeholder, or npos if fmt ended first.
+      exception if fmt is malformed.
+      Runtime complexity: O(length of the text copied).
+  */
+inline size_t vl_format_next (vl_vector_ref<char> &out, std::string_view fmt,
+                              size_t pos, vl_format_spec &spec)
+{
+  while (pos < fmt.size ())
+  {
+    size_t brace = fmt.find_first_of ("{}", pos);
+    if (brace == std::string_view::npos)
+    {
+      vl_append_chars (out, fmt.substr (pos));
+      return std::string_view::npos;
+    }
+    vl_append_chars (out, fmt.substr (pos, brace - pos));
+    if (brace + 1 < fmt.size () && fmt[brace + 1] == fmt[brace])
+    {
+      vl_append_chars (out, fmt.substr (brace, 1)); // "{{" or "}}"
+      pos = brace + 2;
+      continue;
+    }
+    size_t close = fmt.find ('}', brace);
+    if (fmt[brace] == '}' || close == std::string_view::npos)
+    {
+      throw std::invalid_argument ("Unmatched brace in format string");
+    }
+    std::string_view body = fmt.substr (brace + 1, close - brace - 1);
+    if (!body.empty ())
+    {
+      if (body[0] != ':')
+      {
+        throw std::invalid_argument ("Bad placeholder in format string");
+      }
+      body.remove_prefix (1);
+    }
+    spec = vl_format_spec ();
+    if (!body.empty () && body[0] == '.')
+    {
+      const char *last = body.data () + body.size ();
+      std::from_chars_result res = std::from_chars (body.data () + 1, last,
+                                                    spec.precision);
+      if (res.ec != std::errc () || spec.precision < 0)
+      {
+        throw std::invalid_argument ("Bad precision in format string");
+      }
+      body.remove_prefix (res.ptr - body.data ());
+    }
+    if (body.size () == 1)
+    {
+      spec.type = body[0];
+    }
+    else if (!body.empty ())
+    {
+      throw std::invalid_argument ("Bad placeholder in format string");
+    }
+    return close + 1;
+  }
+  return std::string_view::npos;
+}
+
+/** * vl_format_arg() - Appends one argument as its placeholder says.
+      exception if the spec does not apply to the argument type.
+  */
+template<typename T>
+void vl_format_arg (vl_vector_ref<char> &out, const T &arg,
+                    const vl_format_spec &spec)
+{
+  constexpr bool is_int = std::is_integral<T>::value
+                          && !std::is_same<T, bool>::value
+                          && !std::is_same<T, char>::value;
+  constexpr bool is_float = std::is_floating_point<T>::value;
+  const char *types = is_int ? "bdox" : is_float ? "fega" : "";
+  if ((spec.precision >= 0 && !is_float)
+      || (spec.type != 0 && !std::strchr (types, spec.type)))
+  {
+    throw std::invalid_argument ("Format spec does not fit the argument");
+  }
+  if constexpr (std::is_same<T, bool>::value)
+  {
+    vl_append_chars (out, arg ? "true" : "false");
+  }
+  else if constexpr (std::is_same<T, char>::value)
+  {
+    out.push_back (arg);
+  }
+  else if constexpr (is_int)
+  {
+    int base = spec.type == 'b' ? 2 : spec.type == 'o' ? 8
+               : spec.type == 'x' ? 16 : 10;
+    vl_append_int (out, arg, base);
+  }
+  else if constexpr (is_float)
+  {
+    if (spec.type == 0 && spec.precision < 0)
+    {
+      vl_append_float (out, arg);
+    }
+    else
+    {
+      std::chars_format style = spec.type == 'f' ? std::chars_format::fixed
+                                : spec.type == 'e'
+                                ? std::chars_format::scientific
+                                : spec.type == 'a' ? std::chars_format::hex
+                                : std::chars_format::general;
+      vl_append_float (out, arg, style, spec.precision);
+    }
+  }
+  else if constexpr (std::is_convertible<const T &, std::string_view>::value)
+  {
+    vl_append_chars (out, std::string_view (arg));
+  }
+  else
+  {
+    static_assert (std::is_convertible<const T &, std::string_view>::value,
+                   "vl_append_format: argument type cannot be formatted");
+  }
+}
+
+inline void vl_append_format_args (vl_vector_ref<char> &out,
+                                   std::string_view fmt, size_t pos)
+{
+  vl_format_spec spec;
+  if (vl_format_next (out, fmt, pos, spec) != std::string_view::npos)
+  {
+    throw std::invalid_argument ("More placeholders than arguments");
+  }
+}
+
+template<typename T, typename... Rest>
+void vl_append_format_args (vl_vector_ref<char> &out, std::string_view fmt,
+                            size_t pos, const T &arg, const Rest &...rest)
+{
+  vl_format_spec spec;
+  pos = vl_format_next (out, fmt, pos, spec);
+  if (pos == std::string_view::npos)
+  {
+    throw std::invalid_argument ("More arguments than placeholders");
+  }
+  vl_format_arg (out, arg, spec);
+  vl_append_format_args (out, fmt, pos, rest...);
+}
+
+/** * vl_append_format() - Appends fmt with every placeholder replaced
+      by the next argument (see the Format String section).
+      exception if fmt is malformed or does not match the arguments,
+      the size of out is then unchanged.
+      Runtime complexity: O(length of the output).
+  */
+template<typename... Args>
+void vl_append_format (vl_vector_ref<char> &out, std::string_view fmt,
+                       const Args &...args)
+{
+  size_t old_size = out.size ();
+  try
+  {
+    vl_append_format_args (out, fmt, 0, args...);
+  }
+  catch (...)
+  {
+    out.set_size (old_size);
+    throw;
+  }
+}
+
+//<--------Parsing---------->
+/** * vl_parse_range() - The chars [pos, pos + count) of in, with count
+      clamped to the end.
+      exception if pos is past the end.
+  */
+inline std::string_view vl_parse_range (const vl_vector_ref<char> &in,
+                                        size_t pos, size_t count)
+{
+  if (pos > in.size ())
+  {
+    throw std::out_of_range ("Index out of range");
+  }
+  return std::string_view (in.data () + pos,
+                           std::min (count, in.size () - pos));
+}
+
+/** * vl_parse_check() - Turns a from_chars result into the index after
+      the number (stored in *end if end is not null).
+      exception if there was no number or it did not fit.
+  */
+inline void vl_parse_check (std::from_chars_result res, const char *first,
+                            size_t pos, size_t *end)
+{
+  if (res.ec == std::errc::invalid_argument)
+  {
+    throw std::invalid_argument ("No number to parse");
+  }
+  if (res.ec == std::errc::result_out_of_range)
+  {
+    throw std::out_of_range ("Parsed number out of range");
+  }
+  if (end)
+  {
+    *end = pos + (res.ptr - first);
+  }
+}
+
+/** * vl_parse_int() - Parses an integer in base from the chars
+      [pos, pos + count) of in. The index after the last char parsed is
+      stored in *end if end is not null.
+      exception if there is no number there or it does not fit in T.
+      Runtime complexity: O(number of digits).
+  */
+template<typename T>
+T vl_parse_int (const vl_vector_ref<char> &in, size_t pos = 0,
+                size_t count = (size_t) -1, size_t *end = nullptr,
+                int base = 10)
+{
+  static_assert (std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                 "vl_parse_int needs an integer type");
+  std::string_view s = vl_parse_range (in, pos, count);
+  T value = 0;
+  vl_parse_check (std::from_chars (s.data (), s.data () + s.size (), value,
+                                   base),
+                  s.data (), pos, end);
+  return value;
+}
+
+/** * vl_parse_float() - Parses a floating point number in the given
+      format from the chars [pos, pos + count) of in. The index after
+      the last char parsed is stored in *end if end is not null.
+      exception if there is no number there or it does not fit in T.
+      Runtime complexity: O(number of digits).
+  */
+template<typename T>
+T vl_parse_float (const vl_vector_ref<char> &in, size_t pos = 0,
+                  size_t count = (size_t) -1, size_t *end = nullptr,
+                  std::chars_format fmt = std::chars_format::general)
+{
+  static_assert (std::is_floating_point<T>::value,
+                 "vl_parse_float needs a floating point type");
+  std::string_view s = vl_parse_range (in, pos, count);
+  T value = 0;
+  vl_parse_check (std::from_chars (s.data (), s.data () + s.size (), value,
+                                   fmt),
+                  s.data (), pos, end);
+  return value;
+}
+
+#endif //_VL_FORMAT_HPP_
@@ -0,0 +1,610 @@
+//<-----------------Description Section----------------------->
+// This header contains bulk gather / scatter / filter operations for
+// vl_vectors of arithmetic T, the inner loops of column selection and
+// filtering. The output vector is sized once (one reserve() and one
+// set_size()), instead of a capacity check and a stack/heap branch in
+// every push_back, and the loops run on AVX2 / AVX-512 when available.
+//  * vl_gather(out, src, idx)    - appends src[idx[i]] for every i.
+//  * vl_scatter(dst, src, idx)   - dst[idx[i]] = src[i] for every i.
+//  * vl_filter(out, src, mask)   - appends src[i] where mask[i] != 0.
+//  * vl_compress(out, src, bits) - appends src[i] where bit i of the
+//                                  uint64_t words of bits is set.
+//  * vl_select(out, src, pred)   - appends src[i] where pred(src[i]).
+// src, idx, mask and bits may be vl_vectors, vl_spans, std::vectors or
+// anything else with data() and size(). Indices are not checked, as with
+// operator[].
+
+//--------SIMD Kernels-----------//
+// The vector kernels work on 4 and 8 byte elements (int32_t, float,
+// int64_t, double, ...) and 4 and 8 byte indices; other widths use the
+// scalar loops. Gather and scatter use the hardware gather / scatter
+// instructions (scatter only exists on AVX-512). Compression uses
+// vpcompressd/q on AVX-512, and a permute with a lane table on AVX2.
+// The kernel is picked once at run time from the CPU, and the tails go
+// through the scalar code, which is branchless: every element is written
+// to the next free slot, and the slot only advances if it is kept.
+// vl_gather_set_isa(0 / 1) forces the scalar or AVX2 kernels
+// (tests/vl_gather_test.cpp checks every level against reference loops).
+
+#ifndef _VL_GATHER_HPP_
+#define _VL_GATHER_HPP_
+
+//<------------------DEFINE & INCLUDES--------------------->
+#include "vl_vector.hpp"
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+#define VL_GATHER_X86 1
+#define VL_GATHER_AVX2 __attribute__ ((target ("avx2")))
+#define VL_GATHER_AVX512 __attribute__ ((target ("avx512f")))
+#include <immintrin.h>
+#endif
+//<-----------------------IMPLEMENTATION----------------------->
+
+//<--------Scalar Kernels---------->
+/** * vl_mask_word() - Packs the len (at most 64) mask bytes of m into a
+      word, bit j set if m[j] != 0.
+      Runtime complexity: O(len).
+  */
+inline uint64_t vl_mask_word (const unsigned char *m, size_t len) noexcept
+{
+  uint64_t word = 0;
+  size_t j = 0;
+#if defined(VL_GATHER_X86)
+  const __m128i zero = _mm_setzero_si128 ();
+  for (; j + 16 <= len; j += 16)
+  {
+    __m128i bytes = _mm_loadu_si128 ((const __m128i *) (m + j));
+    unsigned zeros = (unsigned) _mm_movemask_epi8 (_mm_cmpeq_epi8 (bytes,
+                                                                   zero));
+    word |= (uint64_t) (~zeros & 0xFFFF) << j;
+  }
+#endif
+  for (; j < len; ++j)
+  {
+    word |= (uint64_t) (m[j] != 0) << j;
+  }
+  return word;
+}
+
+/** * vl_compress_scalar() - Copies src[j], for j in [first, n) with
+      bit j of bits set, to dst[k], dst[k + 1], ...
+      return the new k.
+      Runtime complexity: O(n - first).
+  */
+template<typename T>
+size_t vl_compress_scalar (T *dst, const T *src, const uint64_t *bits,
+                           size_t first, size_t n, size_t k) noexcept
+{
+  for (size_t j = first; j < n; ++j)
+  {
+    dst[k] = src[j];
+    k += (bits[j >> 6] >> (j & 63)) & 1;
+  }
+  return k;
+}
+
+#if defined(VL_GATHER_X86)
+/**
+ * vl_compress_tables - For every keep mask of a 256 bit register, the
+ * source lanes (one byte each) that the kept 32 bit lanes move to the
+ * front: lanes8 for eight 4 byte elements, lanes4 for four 8 byte ones.
+ */
+struct vl_compress_tables
+{
+  uint64_t lanes8[256];
+  uint64_t lanes4[16];
+
+  constexpr vl_compress_tables () : lanes8 (), lanes4 ()
+  {
+    for (unsigned m = 0; m < 256; ++m)
+    {
+      unsigned k = 0;
+      for (unsigned j = 0; j < 8; ++j)
+      {
+        if (m >> j & 1)
+        {
+          lanes8[m] |= (uint64_t) j << (8 * k++);
+        }
+      }
+    }
+    for (unsigned m = 0; m < 16; ++m)
+    {
+      unsigned k = 0;
+      for (unsigned j = 0; j < 4; ++j)
+      {
+        if (m >> j & 1)
+        {
+          lanes4[m] |= (uint64_t) (2 * j) << (8 * k++);
+          lanes4[m] |= (uint64_t) (2 * j + 1) << (8 * k++);
+        }
+      }
+    }
+  }
+};
+
+inline constexpr vl_compress_tables vl_compress_lut {};
+
+//<--------AVX2 Kernels---------->
+/** * vl_gather_avx2() - dst[i] = src[idx[i]] for the whole blocks of n,
+      for W byte elements and IW byte indices.
+      return the number of elements done.
+  */
+template<size_t W, size_t IW>
+VL_GATHER_AVX2 size_t vl_gather_avx2 (void *dst, const void *src,
+                                      const void *idx, size_t n) noexcept
+{
+  char *d = static_cast<char *> (dst);
+  const char *x = static_cast<const char *> (idx);
+  const int *base32 = static_cast<const int *> (src);
+  const long long *base64 = static_cast<const long long *> (src);
+  size_t i = 0;
+  if constexpr (W == 4 && IW == 4)
+  {
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256i vi = _mm256_loadu_si256 ((const __m256i *) (x + i * IW));
+      _mm256_storeu_si256 ((__m256i *) (d + i * W),
+                           _mm256_i32gather_epi32 (base32, vi, 4));
+    }
+  }
+  else if constexpr (W == 8 && IW == 4)
+  {
+    for (; i + 4 <= n; i += 4)
+    {
+      __m128i vi = _mm_loadu_si128 ((const __m128i *) (x + i * IW));
+      _mm256_storeu_si256 ((__m256i *) (d + i * W),
+                           _mm256_i32gather_epi64 (base64, vi, 8));
+    }
+  }
+  else if constexpr (W == 4 && IW == 8)
+  {
+    for (; i + 4 <= n; i += 4)
+    {
+      __m256i vi = _mm256_loadu_si256 ((const __m256i *) (x + i * IW));
+      _mm_storeu_si128 ((__m128i *) (d + i * W),
+                        _mm256_i64gather_epi32 (base32, vi, 4));
+    }
+  }
+  else
+  {
+    for (; i + 4 <= n; i += 4)
+    {
+      __m256i vi = _mm256_loadu_si256 ((const __m256i *) (x + i * IW));
+      _mm256_storeu_si256 ((__m256i *) (d + i * W),
+                           _mm256_i64gather_epi64 (base64, vi, 8));
+    }
+  }
+  return i;
+}
+
+/** * vl_compress_avx2() - Moves the kept W byte elements of the whole
+      blocks of n to the front of dst, 8 or 4 at a time, with a lane
+      permute from vl_compress_lut. Each store stays inside dst[0, n).
+      return the number of elements read; written gets the count kept.
+  */
+template<size_t W>
+VL_GATHER_AVX2 size_t vl_compress_avx2 (void *dst, const void *src,
+                                        const uint64_t *bits, size_t n,
+                                        size_t &written) noexcept
+{
+  constexpr size_t lanes = 32 / W;
+  char *d = static_cast<char *> (dst);
+  const char *s = static_cast<const char *> (src);
+  size_t i = 0, k = 0;
+  for (; i + lanes <= n; i += lanes)
+  {
+    unsigned m = (unsigned) (bits[i >> 6] >> (i & 63)) & ((1u << lanes) - 1);
+    uint64_t lut = W == 4 ? vl_compress_lut.lanes8[m]
+                          : vl_compress_lut.lanes4[m];
+    __m256i perm = _mm256_cvtepu8_epi32 (_mm_loadl_epi64 ((const __m128i *)
+                                                          &lut));
+    __m256i v = _mm256_loadu_si256 ((const __m256i *) (s + i * W));
+    _mm256_storeu_si256 ((__m256i *) (d + k * W),
+                         _mm256_permutevar8x32_epi32 (v, perm));
+    k += __builtin_popcount (m);
+  }
+  written = k;
+  return i;
+}
+
+//<--------AVX-512 Kernels---------->
+/** * vl_gather_avx512() - vl_gather_avx2() with 512 bit registers.
+      The masked forms with a zero source avoid undefined registers.
+  */
+template<size_t W, size_t IW>
+VL_GATHER_AVX512 size_t vl_gather_avx512 (void *dst, const void *src,
+                                          const void *idx, size_t n) noexcept
+{
+  char *d = static_cast<char *> (dst);
+  const char *x = static_cast<const char *> (idx);
+  const __m512i zero = _mm512_setzero_si512 ();
+  size_t i = 0;
+  if constexpr (W == 4 && IW == 4)
+  {
+    for (; i + 16 <= n; i += 16)
+    {
+      __m512i vi = _mm512_loadu_si512 (x + i * IW);
+      _mm512_storeu_si512 (d + i * W,
+                           _mm512_mask_i32gather_epi32 (zero, 0xFFFF, vi,
+                                                        src, 4));
+    }
+  }
+  else if constexpr (W == 8 && IW == 4)
+  {
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256i vi = _mm256_loadu_si256 ((const __m256i *) (x + i * IW));
+      _mm512_storeu_si512 (d + i * W,
+                           _mm512_mask_i32gather_epi64 (zero, 0xFF, vi,
+                                                        src, 8));
+    }
+  }
+  else if constexpr (W == 4 && IW == 8)
+  {
+    for (; i + 8 <= n; i += 8)
+    {
+      __m512i vi = _mm512_loadu_si512 (x + i * IW);
+      _mm256_storeu_si256 ((__m256i *) (d + i * W),
+                           _mm512_mask_i64gather_epi32 (
+                               _mm256_setzero_si256 (), 0xFF, vi, src, 4));
+    }
+  }
+  else
+  {
+    for (; i + 8 <= n; i += 8)
+    {
+      __m512i vi = _mm512_loadu_si512 (x + i * IW);
+      _mm512_storeu_si512 (d + i * W,
+                           _mm512_mask_i64gather_epi64 (zero, 0xFF, vi,
+                                                        src, 8));
+    }
+  }
+  return i;
+}
+
+/** * vl_scatter_avx512() - dst[idx[i]] = src[i] for the whole blocks of
+      n. Within a register, lanes with the same index are written in
+      order, so the last one wins, as in the scalar loop.
+      return the number of elements done.
+  */
+template<size_t W, size_t IW>
+VL_GATHER_AVX512 size_t vl_scatter_avx512 (void *dst, const void *src,
+                                           const void *idx, size_t n)
+noexcept
+{
+  const char *s = static_cast<const char *> (src);
+  const char *x = static_cast<const char *> (idx);
+  size_t i = 0;
+  if constexpr (W == 4 && IW == 4)
+  {
+    for (; i + 16 <= n; i += 16)
+    {
+      _mm512_i32scatter_epi32 (dst, _mm512_loadu_si512 (x + i * IW),
+                               _mm512_loadu_si512 (s + i * W), 4);
+    }
+  }
+  else if constexpr (W == 8 && IW == 4)
+  {
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256i vi = _mm256_loadu_si256 ((const __m256i *) (x + i * IW));
+      _mm512_i32scatter_epi64 (dst, vi, _mm512_loadu_si512 (s + i * W), 8);
+    }
+  }
+  else if constexpr (W == 4 && IW == 8)
+  {
+    for (; i + 8 <= n; i += 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (s + i * W));
+      _mm512_i64scatter_epi32 (dst, _mm512_loadu_si512 (x + i * IW), v, 4);
+    }
+  }
+  else
+  {
+    for (; i + 8 <= n; i += 8)
+    {
+      _mm512_i64scatter_epi64 (dst, _mm512_loadu_si512 (x + i * IW),
+                               _mm512_loadu_si512 (s + i * W), 8);
+    }
+  }
+  return i;
+}
+
+/** * vl_compress_avx512() - vl_compress_avx2() with vpcompressd/q,
+      16 or 8 elements at a time.
+  */
+template<size_t W>
+VL_GATHER_AVX512 size_t vl_compress_avx512 (void *dst, const void *src,
+                                            const uint64_t *bits, size_t n,
+                                            size_t &written) noexcept
+{
+  constexpr size_t lanes = 64 / W;
+  char *d = static_cast<char *> (dst);
+  const char *s = static_cast<const char *> (src);
+  size_t i = 0, k = 0;
+  for (; i + lanes <= n; i += lanes)
+  {
+    unsigned m = (unsigned) (bits[i >> 6] >> (i & 63)) & ((1u << lanes) - 1);
+    __m512i v = _mm512_loadu_si512 (s + i * W);
+    if constexpr (W == 4)
+    {
+      v = _mm512_maskz_compress_epi32 ((__mmask16) m, v);
+    }
+    else
+    {
+      v = _mm512_maskz_compress_epi64 ((__mmask8) m, v);
+    }
+    _mm512_storeu_si512 (d + k * W, v);
+    k += __builtin_popcount (m);
+  }
+  written = k;
+  return i;
+}
+#endif
+
+//<--------Dispatch---------->
+/** * vl_gather_cpu_isa() - The widest vector unit of the CPU the
+      kernels can use: 2 for AVX-512F, 1 for AVX2, 0 for none. Checked
+      once.
+  */
+inline int vl_gather_cpu_isa () noexcept
+{
+#if defined(VL_GATHER_X86)
+  static const int isa = __builtin_cpu_supports ("avx512f") ? 2
+                         : __builtin_cpu_supports ("avx2") ? 1 : 0;
+  return isa;
+#else
+  return 0;
+#endif
+}
+
+inline int &vl_gather_isa_switch () noexcept
+{
+  static int isa = vl_gather_cpu_isa ();
+  return isa;
+}
+
+/** * vl_gather_isa() - The vector unit the dispatchers use: the CPU's,
+      unless lowered by vl_gather_set_isa().
+  */
+inline int vl_gather_isa () noexcept
+{
+  return vl_gather_isa_switch ();
+}
+
+/** * vl_gather_set_isa() - Limits the kernels to isa (0 for the scalar
+      loops, 1 for AVX2, 2 for AVX-512F), or less if the CPU lacks it,
+      e.g. to test or benchmark every path.
+      Not thread-safe: call it while no other thread uses the kernels.
+      return the vector unit now used.
+  */
+inline int vl_gather_set_isa (int isa) noexcept
+{
+  vl_gather_isa_switch () = std::max (0, std::min (isa,
+                                                   vl_gather_cpu_isa ()));
+  return vl_gather_isa_switch ();
+}
+
+/** * vl_compress_bits() - Copies src[j], for j in [0, n) with bit j of
+      bits set, to the front of dst.
+      return the number of elements copied.
+      Runtime complexity: O(n).
+  */
+template<typename T>
+size_t vl_compress_bits (T *dst, const T *src, const uint64_t *bits,
+                         size_t n) noexcept
+{
+  size_t i = 0, k = 0;
+#if defined(VL_GATHER_X86)
+  if constexpr (sizeof (T) == 4 || sizeof (T) == 8)
+  {
+    int isa = vl_gather_isa ();
+    if (isa == 2)
+    {
+      i = vl_compress_avx512<sizeof (T)> (dst, src, bits, n, k);
+    }
+    else if (isa == 1)
+    {
+      i = vl_compress_avx2<sizeof (T)> (dst, src, bits, n, k);
+    }
+  }
+#endif
+  return vl_compress_scalar (dst, src, bits, i, n, k);
+}
+
+/** * vl_filter_bytes() - Copies src[j], for j in [0, n) with
+      mask[j] != 0, to the front of dst, 64 elements at a time.
+      return the number of elements copied.
+      Runtime complexity: O(n).
+  */
+template<typename T>
+size_t vl_filter_bytes (T *dst, const T *src, const unsigned char *mask,
+                        size_t n) noexcept
+{
+  size_t k = 0;
+  for (size_t i = 0; i < n; i += 64)
+  {
+    size_t len = std::min (n - i, (size_t) 64);
+    uint64_t word = vl_mask_word (mask + i, len);
+    k += vl_compress_bits (dst + k, src + i, &word, len);
+  }
+  return k;
+}
+
+/**
+ * vl_element_t - The element type of a container with data().
+ */
+template<class Container>
+using vl_element_t = std::remove_cv_t<
+    std::remove_pointer_t<decltype (std::declval<const Container &> ()
+                                        .data ())>>;
+
+//<--------Gather and Scatter---------->
+/** * vl_gather() - Appends src[indices[i]] for every i to out, growing
+      it at most once. Every index must be < src.size ().
+      Runtime complexity: O(indices.size ()).
+  */
+template<typename T, class Source, class Indices>
+void vl_gather (vl_vector_ref<T> &out, const Source &src,
+                const Indices &indices)
+{
+  using I = vl_element_t<Indices>;
+  static_assert (std::is_arithmetic<T>::value,
+                 "vl_gather needs an arithmetic T");
+  static_assert (std::is_same<vl_element_t<Source>, T>::value,
+                 "src must hold the element type of out");
+  static_assert (std::is_integral<I>::value, "indices must be integers");
+  size_t n = indices.size ();
+  size_t old_size = out.size ();
+  out.reserve_more (n);
+  T *d = out.data () + old_size;
+  const T *s = src.data ();
+  const I *x = indices.data ();
+  size_t i = 0;
+#if defined(VL_GATHER_X86)
+  if constexpr ((sizeof (T) == 4 || sizeof (T) == 8)
+                && (sizeof (I) == 4 || sizeof (I) == 8))
+  {
+    // the gather instructions read indices as signed
+    if (std::is_signed<I>::value || sizeof (I) == 8
+        || src.size () <= (size_t) INT32_MAX)
+    {
+      int isa = vl_gather_isa ();
+      if (isa == 2)
+      {
+        i = vl_gather_avx512<sizeof (T), sizeof (I)> (d, s, x, n);
+      }
+      else if (isa == 1)
+      {
+        i = vl_gather_avx2<sizeof (T), sizeof (I)> (d, s, x, n);
+      }
+    }
+  }
+#endif
+  for (; i < n; ++i)
+  {
+    d[i] = s[x[i]];
+  }
+  out.set_size (old_size + n);
+}
+
+/** * vl_scatter() - dst[indices[i]] = src[i] for every i (the last one
+      wins when indices repeat). Every index must be < dst.size ().
+      Runtime complexity: O(src.size ()).
+  */
+template<class Dest, class Source, class Indices>
+void vl_scatter (Dest &dst, const Source &src, const Indices &indices)
+{
+  using T = vl_element_t<Dest>;
+  using I = vl_element_t<Indices>;
+  static_assert (std::is_arithmetic<T>::value,
+                 "vl_scatter needs an arithmetic T");
+  static_assert (std::is_same<vl_element_t<Source>, T>::value,
+                 "src must hold the element type of dst");
+  static_assert (std::is_integral<I>::value, "indices must be integers");
+  size_t n = src.size ();
+  T *d = dst.data ();
+  const T *s = src.data ();
+  const I *x = indices.data ();
+  size_t i = 0;
+#if defined(VL_GATHER_X86)
+  if constexpr ((sizeof (T) == 4 || sizeof (T) == 8)
+                && (sizeof (I) == 4 || sizeof (I) == 8))
+  {
+    if ((std::is_signed<I>::value || sizeof (I) == 8
+         || dst.size () <= (size_t) INT32_MAX)
+        && vl_gather_isa () == 2)
+    {
+      i = vl_scatter_avx512<sizeof (T), sizeof (I)> (d, s, x, n);
+    }
+  }
+#endif
+  for (; i < n; ++i)
+  {
+    d[x[i]] = s[i];
+  }
+}
+
+//<--------Filtering---------->
+/** * vl_filter() - Appends to out every src[i] with mask[i] != 0,
+      growing it at most once. mask holds one byte per element (bool,
+      char, uint8_t) and is at least as long as src.
+      Runtime complexity: O(src.size ()).
+  */
+template<typename T, class Source, class Mask>
+void vl_filter (vl_vector_ref<T> &out, const Source &src, const Mask &mask)
+{
+  static_assert (std::is_arithmetic<T>::value,
+                 "vl_filter needs an arithmetic T");
+  static_assert (std::is_same<vl_element_t<Source>, T>::value,
+                 "src must hold the element type of out");
+  static_assert (sizeof (vl_element_t<Mask>) == 1,
+                 "mask must hold one byte per element");
+  size_t n = src.size ();
+  size_t old_size = out.size ();
+  out.reserve_more (n);
+  const unsigned char *m = reinterpret_cast<const unsigned char *> (
+      mask.data ());
+  size_t kept = vl_filter_bytes (out.data () + old_size, src.data (), m, n);
+  out.set_size (old_size + kept);
+}
+
+/** * vl_compress() - Appends to out every src[i] with bit i % 64 of
+      bits[i / 64] set, growing it at most once. bits holds uint64_t
+      words, at least (src.size () + 63) / 64 of them.
+      Runtime complexity: O(src.size ()).
+  */
+template<typename T, class Source, class Bits>
+void vl_compress (vl_vector_ref<T> &out, const Source &src, const Bits &bits)
+{
+  static_assert (std::is_arithmetic<T>::value,
+                 "vl_compress needs an arithmetic T");
+  static_assert (std::is_same<vl_element_t<Source>, T>::value,
+                 "src must hold the element type of out");
+  static_assert (std::is_same<vl_element_t<Bits>, uint64_t>::value,
+                 "bits must hold uint64_t words");
+  size_t n = src.size ();
+  size_t old_size = out.size ();
+  out.reserve_more (n);
+  size_t kept = vl_compress_bits (out.data () + old_size, src.data (),
+                                  bits.data (), n);
+  out.set_size (old_size + kept);
+}
+
+/** * vl_select() - Appends to out every element x of src with pred (x),
+      growing it at most once. pred runs over blocks of 64 elements into
+      a byte mask (a loop the compiler can vectorize for simple
+      predicates), which is then compressed as in vl_filter().
+      Runtime complexity: O(src.size ()) calls of pred.
+  */
+template<typename T, class Source, class Predicate>
+void vl_select (vl_vector_ref<T> &out, const Source &src, Predicate pred)
+{
+  static_assert (std::is_arithmetic<T>::value,
+                 "vl_select needs an arithmetic T");
+  static_assert (std::is_same<vl_element_t<Source>, T>::value,
+                 "src must hold the element type of out");
+  size_t n = src.size ();
+  size_t old_size = out.size ();
+  out.reserve_more (n);
+  T *d = out.data () + old_size;
+  const T *s = src.data ();
+  size_t k = 0;
+  unsigned char keep[64];
+  for (size_t i = 0; i < n; i += 64)
+  {
+    size_t len = std::min (n - i, (size_t) 64);
+    for (size_t j = 0; j < len; ++j)
+    {
+      keep[j] = pred (s[i + j]) ? 1 : 0;
+    }
+    k += vl_filter_bytes (d + k, s + i, keep, len);
+  }
+  out.set_size (old_size + k);
+}
+
+#endif //_VL_GATHER_HPP_
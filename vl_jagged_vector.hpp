@@ -0,0 +1,488 @@
+//<-----------------Description Section----------------------->
+// This header contains vl_jagged_vector, a container of many small
+// sequences (rows) packed CSR style: every row lives in one contiguous
+// values array, and an offsets array marks where each row starts.
+// Compared to a vector of vl_vectors, a row costs one offset instead of a
+// whole vl_vector (stack buffer, size, capacity...), rows never spill to
+// their own heap blocks, and scanning the rows in order reads memory
+// sequentially.
+
+//--------Building-----------//
+// Rows are appended at the end: push_row() opens a new row and
+// push_back() appends to the last row, both in amortized O(1).
+// When the values arrive in any row order (e.g. graph edges),
+// vl_jagged_builder collects (row, value) pairs and freeze() lays them
+// out in one counting-sort pass.
+
+//--------Row Access-----------//
+// operator[] and at() return a vl_span: a view with the same element
+// access and iterator types as vl_vector (size, empty, data, operator[],
+// at, begin, end), so code written against a vl_vector's elements also
+// works on a row.
+
+#ifndef _VL_JAGGED_VECTOR_HPP_
+#define _VL_JAGGED_VECTOR_HPP_
+
+//<------------------DEFINE & INCLUDES--------------------->
+#include "vl_vector.hpp"
+#include <cstdint>
+#include <limits>
+//<-----------------------IMPLEMENTATION----------------------->
+
+/**
+ * vl_span_iterators - The vl_vector iterator type matching a (possibly
+ * const) element type.
+ */
+template<typename T>
+struct vl_span_iterators
+{
+  using type = typename vl_vector_ref<T>::iterator;
+};
+
+template<typename T>
+struct vl_span_iterators<const T>
+{
+  using type = typename vl_vector_ref<T>::const_iterator;
+};
+
+/**
+ * vl_span - A non-owning view of n contiguous elements, with the element
+ * access interface of vl_vector. T may be const for a read-only view.
+ */
+template<typename T>
+class vl_span
+{
+ public:
+  using iterator = typename vl_span_iterators<T>::type;
+
+  vl_span () noexcept : v_data (nullptr), v_size (0) {}
+
+  vl_span (T *data, size_t size) noexcept : v_data (data), v_size (size) {}
+
+/** * size() - Returns the number of elements in the view.
+      Runtime complexity: O(1).
+  */
+  size_t size () const noexcept
+  {
+    return v_size;
+  }
+
+/** * empty() - Returns whether the view is empty.
+      Runtime complexity: O(1).
+  */
+  bool empty () const noexcept
+  {
+    return v_size == 0;
+  }
+
+/** * data() - Returns a pointer to the first element.
+      Runtime complexity: O(1).
+  */
+  T *data () const noexcept
+  {
+    return v_data;
+  }
+
+/** * operator[] - Accesses the element at the specified index.
+      Runtime complexity: O(1).
+  */
+  T &operator[] (size_t index) const noexcept
+  {
+    return v_data[index];
+  }
+
+/** * at() - Accesses the element at the specified index with bounds check.
+      exception if the index out of range.
+      Runtime complexity: O(1).
+  */
+  T &at (size_t index) const noexcept (false)
+  {
+    if (index >= v_size)
+    {
+      throw std::out_of_range ("Index out of range");
+    }
+    return v_data[index];
+  }
+
+  iterator begin () const noexcept
+  {
+    return iterator (v_data);
+  }
+
+  iterator end () const noexcept
+  {
+    return iterator (v_data + v_size);
+  }
+
+ private:
+  T *v_data;
+  size_t v_size;
+};
+
+/**
+ * vl_jagged_vector - Rows of T packed into one values array, with the
+ * start of every row kept in an offsets array of offset_type (which
+ * bounds the total number of values).
+ */
+template<typename T, typename offset_type = uint32_t>
+class vl_jagged_vector
+{
+ public:
+  using row = vl_span<T>;
+  using const_row = vl_span<const T>;
+
+  //<--------Constructors---------->
+
+  /**  * Default constructor, no rows.
+         Runtime complexity: O(1).
+   */
+  vl_jagged_vector ()
+  {
+    v_offsets.push_back (0);
+  }
+
+  /**  * Constructor from a list of rows.
+         Runtime complexity: O(n) - total number of values.
+   */
+  vl_jagged_vector (std::initializer_list<std::initializer_list<T>> rows)
+      : vl_jagged_vector ()
+  {
+    for (const std::initializer_list<T> &r: rows)
+    {
+      push_row (r.begin (), r.end ());
+    }
+  }
+
+//<--------Capacity---------->
+
+/**  * size() - Returns the number of rows.
+       Runtime complexity: O(1).
+ */
+  size_t size () const noexcept
+  {
+    return v_offsets.size () - 1;
+  }
+
+/**  * empty() - Returns whether there are no rows.
+       Runtime complexity: O(1).
+ */
+  bool empty () const noexcept
+  {
+    return size () == 0;
+  }
+
+/**  * values_size() - Returns the number of values in all the rows.
+       Runtime complexity: O(1).
+ */
+  size_t values_size () const noexcept
+  {
+    return v_values.size ();
+  }
+
+/**  * row_size() - Returns the number of values in row i.
+       Runtime complexity: O(1).
+ */
+  size_t row_size (size_t i) const noexcept
+  {
+    return v_offsets[i + 1] - v_offsets[i];
+  }
+
+/**  * reserve() - Makes room for 'rows' rows holding 'values' values.
+       Runtime complexity: O(n) if the arrays grow, O(1) otherwise.
+ */
+  void reserve (size_t rows, size_t values)
+  {
+    v_offsets.reserve (rows + 1);
+    v_values.reserve (values);
+  }
+
+//<--------Modifiers---------->
+
+/**  * push_row() - Appends a new, empty last row.
+       Runtime complexity: O(1) amortized.
+ */
+  void push_row ()
+  {
+    v_offsets.push_back (v_offsets[v_offsets.size () - 1]);
+  }
+
+/**  * push_row() - Appends a new last row holding [first, last).
+       Runtime complexity: O(n) - number of elements in the range.
+ */
+  template<class ForwardIterator>
+  void push_row (ForwardIterator first, ForwardIterator last)
+  {
+    size_t count = std::distance (first, last);
+    check_offset (v_values.size () + count);
+    v_values.reserve_more (count);
+    for (ForwardIterator it = first; it != last; ++it)
+    {
+      v_values.push_back (*it);
+    }
+    v_offsets.push_back ((offset_type) v_values.size ());
+  }
+
+/**  * push_back() - Appends a value to the last row.
+       exception if there are no rows.
+       Runtime complexity: O(1) amortized.
+ */
+  void push_back (const T &value) noexcept (false)
+  {
+    if (empty ())
+    {
+      throw std::out_of_range ("push_back on a jagged vector with no rows");
+    }
+    check_offset (v_values.size () + 1);
+    v_values.push_back (value);
+    ++v_offsets[v_offsets.size () - 1];
+  }
+
+/**  * pop_row() - Removes the last row and its values.
+       Runtime complexity: O(1) amortized, like pop_back().
+ */
+  void pop_row () noexcept
+  {
+    if (!empty ())
+    {
+      v_offsets.pop_back ();
+      size_t end = v_offsets[v_offsets.size () - 1];
+      if (v_values.size () > end)
+      {
+        // drop the whole row at once, then let one pop_back() move the
+        // values back to the stack if they fit there now
+        v_values.set_size (end + 1);
+        v_values.pop_back ();
+      }
+    }
+  }
+
+/**  * clear() - Removes all the rows.
+       Runtime complexity: O(n) - number of values.
+ */
+  void clear () noexcept
+  {
+    v_values.clear ();
+    v_offsets.clear ();
+    v_offsets.push_back (0);
+  }
+
+//<--------Row Access---------->
+
+/** * operator[] - Returns a view of row i.
+      Runtime complexity: O(1).
+  */
+  row operator[] (size_t i) noexcept
+  {
+    return row (v_values.data () + v_offsets[i], row_size (i));
+  }
+
+/** * operator[] - const version of the operator[].
+      Runtime complexity: O(1).
+  */
+  const_row operator[] (size_t i) const noexcept
+  {
+    return const_row (v_values.data () + v_offsets[i], row_size (i));
+  }
+
+/** * at() - Returns a view of row i with bounds check.
+      exception if the index out of range.
+      Runtime complexity: O(1).
+  */
+  row at (size_t i) noexcept (false)
+  {
+    if (i >= size ())
+    {
+      throw std::out_of_range ("Index out of range");
+    }
+    return (*this)[i];
+  }
+
+/** * at() - const version of the at() function.
+      Runtime complexity: O(1).
+  */
+  const_row at (size_t i) const noexcept (false)
+  {
+    if (i >= size ())
+    {
+      throw std::out_of_range ("Index out of range");
+    }
+    return (*this)[i];
+  }
+
+/** * values() - The values of all the rows, row after row.
+      Runtime complexity: O(1).
+  */
+  const vl_vector_ref<T> &values () const noexcept
+  {
+    return v_values;
+  }
+
+/** * offsets() - size() + 1 offsets: row i is [offsets[i], offsets[i + 1]).
+      Runtime complexity: O(1).
+  */
+  const vl_vector_ref<offset_type> &offsets () const noexcept
+  {
+    return v_offsets;
+  }
+
+//<--------Iterators---------->
+
+/**
+ * row_iterator - Iterates over the rows, yielding a view of each.
+ */
+  template<class jagged, class view>
+  class row_iterator
+  {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = view;
+
+    row_iterator (jagged *owner, size_t i) : m_owner (owner), m_i (i) {}
+
+    view operator* () const { return (*m_owner)[m_i]; }
+
+    row_iterator &operator++ ()
+    {
+      ++m_i;
+      return *this;
+    }
+
+    row_iterator operator++ (int)
+    {
+      row_iterator tmp = *this;
+      ++m_i;
+      return tmp;
+    }
+
+    friend bool operator== (const row_iterator &lhs, const row_iterator &rhs)
+    {
+      return lhs.m_i == rhs.m_i;
+    }
+
+    friend bool operator!= (const row_iterator &lhs, const row_iterator &rhs)
+    {
+      return lhs.m_i != rhs.m_i;
+    }
+
+   private:
+    jagged *m_owner;
+    size_t m_i;
+  };
+
+  using iterator = row_iterator<vl_jagged_vector, row>;
+  using const_iterator = row_iterator<const vl_jagged_vector, const_row>;
+
+  iterator begin () noexcept
+  {
+    return iterator (this, 0);
+  }
+
+  iterator end () noexcept
+  {
+    return iterator (this, size ());
+  }
+
+  const_iterator begin () const noexcept
+  {
+    return const_iterator (this, 0);
+  }
+
+  const_iterator end () const noexcept
+  {
+    return const_iterator (this, size ());
+  }
+
+ private:
+  template<typename, typename> friend class vl_jagged_builder;
+
+  vl_vector<T> v_values; // All the rows, one after the other
+  vl_vector<offset_type> v_offsets; // Row starts, plus the end of the last
+
+/** * check_offset() - Throws if n values cannot be indexed by offset_type.
+  */
+  static void check_offset (size_t n)
+  {
+    if (n > (size_t) std::numeric_limits<offset_type>::max ())
+    {
+      throw std::length_error ("vl_jagged_vector offset_type overflow");
+    }
+  }
+};
+
+/**
+ * vl_jagged_builder - Collects (row, value) pairs in any order, then
+ * freeze() packs them into a vl_jagged_vector with the values of each
+ * row in insertion order.
+ */
+template<typename T, typename offset_type = uint32_t>
+class vl_jagged_builder
+{
+ public:
+/** * add() - Adds value to row 'row' (rows are created as needed).
+      Runtime complexity: O(1) amortized.
+  */
+  void add (size_t row, const T &value)
+  {
+    b_rows.push_back (row);
+    b_values.push_back (value);
+    if (row >= b_num_rows)
+    {
+      b_num_rows = row + 1;
+    }
+  }
+
+/** * reserve() - Makes room for n (row, value) pairs.
+      Runtime complexity: O(n) if the buffers grow, O(1) otherwise.
+  */
+  void reserve (size_t n)
+  {
+    b_rows.reserve (n);
+    b_values.reserve (n);
+  }
+
+/** * freeze() - Builds the jagged vector with at least 'rows' rows
+      (counting sort on the row index) and empties the builder.
+      Runtime complexity: O(number of pairs + number of rows).
+  */
+  vl_jagged_vector<T, offset_type> freeze (size_t rows = 0)
+  {
+    vl_jagged_vector<T, offset_type> out;
+    size_t n = b_values.size ();
+    out.check_offset (n);
+    rows = std::max (rows, b_num_rows);
+    vl_vector_ref<offset_type> &offsets = out.v_offsets;
+    offsets.reserve (rows + 1);
+    offsets.set_size (rows + 1);
+    std::fill (offsets.begin (), offsets.end (), offset_type (0));
+    for (size_t i = 0; i < n; ++i) // count the values of every row
+    {
+      ++offsets[b_rows[i] + 1];
+    }
+    for (size_t r = 0; r < rows; ++r) // prefix sums: row starts
+    {
+      offsets[r + 1] += offsets[r];
+    }
+    vl_vector<offset_type> next (offsets.begin (), offsets.end () - 1);
+    vl_vector_ref<T> &values = out.v_values;
+    values.reserve (n);
+    values.set_size (n);
+    for (size_t i = 0; i < n; ++i) // place every value in its row
+    {
+      values[next[b_rows[i]]++] = b_values[i];
+    }
+    b_rows.clear ();
+    b_values.clear ();
+    b_num_rows = 0;
+    return out;
+  }
+
+ private:
+  vl_vector<size_t> b_rows;
+  vl_vector<T> b_values;
+  size_t b_num_rows = 0;
+};
+
+#endif //_VL_JAGGED_VECTOR_HPP_
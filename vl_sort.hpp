@@ -0,0 +1,404 @@
+//<-----------------Description Section----------------------->
+// This header contains vl_sort, a sort for vl_vectors (and anything else
+// with data() and size(), e.g. a vl_span row) that picks the algorithm
+// from the size and the element type:
+//  * up to VL_SORT_NETWORK_MAX elements (the inline case, the default
+//    static capacity is 16) - a sorting network generated at compile time,
+//    run with branchless compare-exchanges.
+//  * VL_RADIX_SORT_MIN elements or more of an integral or floating point
+//    key - LSD radix sort, one byte per pass, with a per-thread scratch
+//    buffer that is reused across calls (one larger than
+//    VL_RADIX_SCRATCH_MAX bytes is only kept while it is at most twice
+//    the size of the last sort).
+//  * anything else - std::sort (introsort).
+
+//--------Variants-----------//
+// vl_sort(v) / vl_sort(v, comp)               - not stable.
+// vl_stable_sort(v) / vl_stable_sort(v, comp) - stable: insertion sort for
+//                                               small sizes, radix sort or
+//                                               std::stable_sort otherwise.
+// vl_sort_by_key(v, key) / vl_stable_sort_by_key(v, key)
+//                         - order by key(element); radix sorts on the key
+//                           when it is arithmetic and T is trivial.
+// A custom comparator disables the radix sort.
+// v may be an lvalue or a temporary view, e.g. vl_sort(jagged[0]).
+
+//--------Radix Key Order-----------//
+// Signed integers and floats are mapped to unsigned integers with the
+// same order. -0.0 is mapped like 0.0, so the two are equal as they are
+// for std::less and the stable sorts keep them in input order. NaNs sort
+// before (negative sign) or after (positive sign) all the other values.
+
+#ifndef _VL_SORT_HPP_
+#define _VL_SORT_HPP_
+
+//<------------------DEFINE & INCLUDES--------------------->
+#ifndef VL_SORT_NETWORK_MAX // largest size sorted by a sorting network
+#define VL_SORT_NETWORK_MAX 32
+#endif
+#ifndef VL_RADIX_SORT_MIN // smallest size sorted by radix sort
+#define VL_RADIX_SORT_MIN 1024
+#endif
+#ifndef VL_RADIX_SCRATCH_MAX // radix scratch always kept between calls
+#define VL_RADIX_SCRATCH_MAX (1 << 20) // bytes
+#endif
+
+#include "vl_vector.hpp"
+#include <cstdint>
+#include <utility>
+//<-----------------------IMPLEMENTATION----------------------->
+
+static_assert (VL_SORT_NETWORK_MAX <= 64,
+               "sorting networks are generated for up to 64 elements");
+
+//<--------Sorting Networks---------->
+/** * vl_batcher_network() - Generates Batcher's odd-even merge sort
+      network for n elements: the comparators (i, j), i < j, in order.
+      Comparators that reach past n are left out, which is the same as
+      padding the input with elements greater than all the others.
+      When 'write' is false the comparators are only counted.
+      return the number of comparators.
+  */
+constexpr size_t vl_batcher_network (size_t n, uint8_t (*out)[2] = nullptr,
+                                     bool write = false)
+{
+  size_t count = 0;
+  for (size_t p = 1; p < n; p *= 2)
+  {
+    for (size_t k = p; k >= 1; k /= 2)
+    {
+      for (size_t j = k % p; j + k < n; j += 2 * k)
+      {
+        for (size_t i = 0; i < k && i + j + k < n; ++i)
+        {
+          if ((i + j) / (2 * p) == (i + j + k) / (2 * p))
+          {
+            if (write)
+            {
+              out[count][0] = (uint8_t) (i + j);
+              out[count][1] = (uint8_t) (i + j + k);
+            }
+            ++count;
+          }
+        }
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * vl_sort_networks - The networks for every size from 0 to
+ * VL_SORT_NETWORK_MAX, built at compile time.
+ */
+struct vl_sort_networks
+{
+  static constexpr size_t max_size = VL_SORT_NETWORK_MAX;
+  static constexpr size_t max_pairs = vl_batcher_network (max_size);
+
+  uint16_t count[max_size + 1] = {};
+  uint8_t pairs[max_size + 1][max_pairs > 0 ? max_pairs : 1][2] = {};
+
+  constexpr vl_sort_networks ()
+  {
+    for (size_t n = 0; n <= max_size; ++n)
+    {
+      count[n] = (uint16_t) vl_batcher_network (n, pairs[n], true);
+    }
+  }
+};
+
+inline constexpr vl_sort_networks vl_networks {};
+
+/** * vl_network_sort() - Sorts n <= VL_SORT_NETWORK_MAX elements with the
+      network for n. Each compare-exchange selects instead of branching,
+      so the compiler can emit conditional moves / min-max instructions.
+      Runtime complexity: O(n log^2 n) comparisons, no mispredictions.
+  */
+template<typename T, class Less>
+void vl_network_sort (T *x, size_t n, Less less)
+{
+  const uint8_t (*pairs)[2] = vl_networks.pairs[n];
+  for (size_t c = 0, count = vl_networks.count[n]; c < count; ++c)
+  {
+    T &a = x[pairs[c][0]];
+    T &b = x[pairs[c][1]];
+    T lo = a;
+    T hi = b;
+    bool swap = less (hi, lo);
+    a = swap ? hi : lo;
+    b = swap ? lo : hi;
+  }
+}
+
+/** * vl_insertion_sort() - Stable sort for small sizes.
+      Runtime complexity: O(n^2).
+  */
+template<typename T, class Less>
+void vl_insertion_sort (T *x, size_t n, Less less)
+{
+  for (size_t i = 1; i < n; ++i)
+  {
+    T value = std::move (x[i]);
+    size_t j = i;
+    for (; j > 0 && less (value, x[j - 1]); --j)
+    {
+      x[j] = std::move (x[j - 1]);
+    }
+    x[j] = std::move (value);
+  }
+}
+
+//<--------Radix Sort---------->
+/** * vl_radix_bits() - Maps an arithmetic key to an unsigned integer of
+      the same size whose order is the order of the keys.
+  */
+template<typename K>
+auto vl_radix_bits (K key) noexcept
+{
+  using U = std::conditional_t<sizeof (K) == 1, uint8_t,
+            std::conditional_t<sizeof (K) == 2, uint16_t,
+            std::conditional_t<sizeof (K) == 4, uint32_t, uint64_t>>>;
+  if constexpr (std::is_floating_point<K>::value)
+  {
+    if (key == 0)
+    {
+      key = 0; // -0.0 equals 0.0
+    }
+  }
+  U bits;
+  std::memcpy (&bits, &key, sizeof (K));
+  const U sign = U (1) << (sizeof (K) * 8 - 1);
+  if constexpr (std::is_floating_point<K>::value)
+  {
+    // Negative: flip all the bits (larger magnitude sorts first).
+    // Positive: flip only the sign bit (sorts after the negatives).
+    return U (bits ^ ((bits & sign) ? U (~U (0)) : sign));
+  }
+  else if constexpr (std::is_signed<K>::value)
+  {
+    return U (bits ^ sign);
+  }
+  else
+  {
+    return bits;
+  }
+}
+
+/**
+ * vl_radix_sortable - Whether elements of T ordered by keys of type K
+ * can be radix sorted: the key is integral or floating point of up to 8
+ * bytes, and T can be moved around with memcpy.
+ */
+template<typename T, typename K>
+constexpr bool vl_radix_sortable =
+    std::is_arithmetic<K>::value && !std::is_same<K, bool>::value
+    && sizeof (K) <= 8 && (sizeof (K) & (sizeof (K) - 1)) == 0
+    && (std::is_integral<K>::value || sizeof (K) >= 4)
+    && std::is_trivial<T>::value;
+
+/** * vl_radix_sort() - Stable LSD radix sort of n elements by key, one
+      byte per pass. The histograms of all the bytes are counted in one
+      read of the input, and a byte that is the same in every key is
+      skipped. The scratch buffer is kept per thread and allocated at
+      exactly n elements when it is too small. Above VL_RADIX_SCRATCH_MAX
+      bytes it is freed after a sort of less than half its size, so a
+      run of large sorts reuses it but one outlier does not pin it.
+      Runtime complexity: O(n * sizeof(key)).
+  */
+template<typename T, class Key>
+void vl_radix_sort (T *x, size_t n, Key key)
+{
+  using K = std::decay_t<decltype (key (*x))>;
+  constexpr size_t digits = sizeof (K);
+  static thread_local vl_vector<T, 1> scratch;
+  if (scratch.capacity () < n)
+  {
+    scratch.clear (); // nothing to keep: do not let realloc copy it
+    scratch.reserve (n);
+  }
+
+  size_t counts[digits][256] = {};
+  for (size_t i = 0; i < n; ++i)
+  {
+    auto bits = vl_radix_bits (key (x[i]));
+    for (size_t d = 0; d < digits; ++d)
+    {
+      ++counts[d][(bits >> (8 * d)) & 0xff];
+    }
+  }
+
+  T *src = x;
+  T *dst = scratch.data ();
+  for (size_t d = 0; d < digits; ++d)
+  {
+    size_t *count = counts[d];
+    if (count[(vl_radix_bits (key (src[0])) >> (8 * d)) & 0xff] == n)
+    {
+      continue; // every key has the same byte here
+    }
+    size_t sum = 0;
+    for (size_t b = 0; b < 256; ++b) // counts to starting positions
+    {
+      size_t c = count[b];
+      count[b] = sum;
+      sum += c;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      dst[count[(vl_radix_bits (key (src[i])) >> (8 * d)) & 0xff]++] = src[i];
+    }
+    std::swap (src, dst);
+  }
+  if (src != x)
+  {
+    std::memcpy (x, src, n * sizeof (T));
+  }
+  if (scratch.capacity () * sizeof (T) > VL_RADIX_SCRATCH_MAX
+      && scratch.capacity () / 2 > n)
+  {
+    scratch.clear (); // frees the heap block
+  }
+}
+
+//<--------Dispatch---------->
+/**
+ * vl_identity - Key of the plain sorts: the element itself.
+ */
+struct vl_identity
+{
+  template<typename U>
+  const U &operator() (const U &u) const noexcept
+  {
+    return u;
+  }
+};
+
+/**
+ * vl_key_less - Compares two elements by their keys.
+ */
+template<class Key>
+struct vl_key_less
+{
+  Key key;
+
+  template<typename U>
+  bool operator() (const U &a, const U &b) const
+  {
+    return key (a) < key (b);
+  }
+};
+
+/** * vl_sort_dispatch() - Sorts n elements at x by 'less'. 'key' is used
+      for the radix sort when radix is true (which requires 'less' to
+      order by key).
+  */
+template<bool stable, bool radix, typename T, class Less, class Key>
+void vl_sort_dispatch (T *x, size_t n, Less less, Key key)
+{
+  if (n < 2)
+  {
+    return;
+  }
+  if (n <= VL_SORT_NETWORK_MAX)
+  {
+    if constexpr (!stable && std::is_trivially_copyable<T>::value
+                  && sizeof (T) <= 16)
+    {
+      vl_network_sort (x, n, less);
+    }
+    else
+    {
+      vl_insertion_sort (x, n, less);
+    }
+    return;
+  }
+  if constexpr (radix)
+  {
+    if (n >= VL_RADIX_SORT_MIN)
+    {
+      vl_radix_sort (x, n, key);
+      return;
+    }
+  }
+  if constexpr (stable)
+  {
+    std::stable_sort (x, x + n, less);
+  }
+  else
+  {
+    std::sort (x, x + n, less);
+  }
+}
+
+//<--------Public Interface---------->
+/** * vl_sort() - Sorts the elements of v in ascending order.
+      Runtime complexity: O(n log n), O(n) for large arithmetic vectors.
+  */
+template<class Vector>
+void vl_sort (Vector &&v)
+{
+  using T = std::remove_reference_t<decltype (*v.data ())>;
+  vl_sort_dispatch<false, vl_radix_sortable<T, T>>
+      (v.data (), v.size (), std::less<T> (), vl_identity ());
+}
+
+/** * vl_sort() - Sorts the elements of v by comp.
+      Runtime complexity: O(n log n).
+  */
+template<class Vector, class Compare>
+void vl_sort (Vector &&v, Compare comp)
+{
+  vl_sort_dispatch<false, false> (v.data (), v.size (), comp, vl_identity ());
+}
+
+/** * vl_stable_sort() - Sorts the elements of v in ascending order,
+      keeping the order of equal elements.
+      Runtime complexity: O(n log n), O(n) for large arithmetic vectors.
+  */
+template<class Vector>
+void vl_stable_sort (Vector &&v)
+{
+  using T = std::remove_reference_t<decltype (*v.data ())>;
+  vl_sort_dispatch<true, vl_radix_sortable<T, T>>
+      (v.data (), v.size (), std::less<T> (), vl_identity ());
+}
+
+/** * vl_stable_sort() - Sorts the elements of v by comp, keeping the
+      order of equal elements.
+      Runtime complexity: O(n log n).
+  */
+template<class Vector, class Compare>
+void vl_stable_sort (Vector &&v, Compare comp)
+{
+  vl_sort_dispatch<true, false> (v.data (), v.size (), comp, vl_identity ());
+}
+
+/** * vl_sort_by_key() - Sorts the elements of v by key(element).
+      Runtime complexity: O(n log n), O(n) for large vectors of trivial
+      elements with arithmetic keys.
+  */
+template<class Vector, class Key>
+void vl_sort_by_key (Vector &&v, Key key)
+{
+  using T = std::remove_reference_t<decltype (*v.data ())>;
+  using K = std::decay_t<decltype (key (*v.data ()))>;
+  vl_sort_dispatch<false, vl_radix_sortable<T, K>>
+      (v.data (), v.size (), vl_key_less<Key> {key}, key);
+}
+
+/** * vl_stable_sort_by_key() - Sorts the elements of v by key(element),
+      keeping the order of elements with equal keys.
+      Runtime complexity: O(n log n), O(n) for large vectors of trivial
+      elements with arithmetic keys.
+  */
+template<class Vector, class Key>
+void vl_stable_sort_by_key (Vector &&v, Key key)
+{
+  using T = std::remove_reference_t<decltype (*v.data ())>;
+  using K = std::decay_t<decltype (key (*v.data ()))>;
+  vl_sort_dispatch<true, vl_radix_sortable<T, K>>
+      (v.data (), v.size (), vl_key_less<Key> {key}, key);
+}
+
+#endif //_VL_SORT_HPP_
@@ -0,0 +1,907 @@
+//<-----------------Description Section----------------------->
+// This header contains vl_string, a string class built on top of
+// vl_vector<char>: short strings live on the stack, longer ones on the
+// heap, with the same growth and the same interface as vl_vector.
+// It also contains the byte-level kernels the string operations use:
+// find a char, find a substring, find the first of a set of chars,
+// split, ASCII case folding, trimming and UTF-8 validation.
+
+//--------SIMD Kernels-----------//
+// Every kernel has a scalar version, an SSE2 version (always available on
+// x86-64) and an AVX2 version that is picked at run time when the CPU
+// supports it. The kernels only read inside [p, p + n): full 16/32 byte
+// blocks go through the vector unit and the tail through the scalar code.
+// vl_str_set_avx2(false) forces the SSE2 kernels (tests/vl_string_test.cpp
+// checks both against the scalar ones).
+
+//--------Views-----------//
+// split() and trim_view() return std::string_views into the string
+// buffer, without allocating per piece. They are invalidated like
+// iterators, by any change that reallocates or shifts the buffer.
+
+#ifndef _VL_STRING_HPP_
+#define _VL_STRING_HPP_
+
+//<------------------DEFINE & INCLUDES--------------------->
+#include "vl_format.hpp"
+#include "vl_vector.hpp"
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#if (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+#define VL_STRING_X86 1
+#define VL_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#include <immintrin.h>
+#endif
+//<-----------------------IMPLEMENTATION----------------------->
+
+//<--------Scalar Kernels---------->
+/** * vl_str_find_char_scalar() - Index of the first c in [p, p + n),
+      or n if there is none.
+  */
+inline size_t vl_str_find_char_scalar (const char *p, size_t n, char c)
+noexcept
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (p[i] == c)
+    {
+      return i;
+    }
+  }
+  return n;
+}
+
+/** * vl_str_find_first_of_scalar() - Index of the first char of [p, p + n)
+      that is in the set [set, set + k), or n if there is none.
+  */
+inline size_t vl_str_find_first_of_scalar (const char *p, size_t n,
+                                           const char *set, size_t k) noexcept
+{
+  bool in_set[256] = {};
+  for (size_t j = 0; j < k; ++j)
+  {
+    in_set[(unsigned char) set[j]] = true;
+  }
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (in_set[(unsigned char) p[i]])
+    {
+      return i;
+    }
+  }
+  return n;
+}
+
+/** * vl_str_ascii_case_scalar() - Adds delta to every char in [lo, hi]
+      (to lower case: 'A'..'Z' and 0x20, to upper: 'a'..'z' and -0x20).
+  */
+inline void vl_str_ascii_case_scalar (char *p, size_t n, char lo, char hi,
+                                      char delta) noexcept
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (p[i] >= lo && p[i] <= hi)
+    {
+      p[i] = (char) (p[i] + delta);
+    }
+  }
+}
+
+/** * vl_str_utf8_char() - Validates the UTF-8 sequence starting at p[i]
+      (RFC 3629: no overlong forms, no surrogates, at most U+10FFFF).
+      return its length, or 0 if it is invalid or cut off by n.
+  */
+inline size_t vl_str_utf8_char (const unsigned char *p, size_t i, size_t n)
+noexcept
+{
+  unsigned char c = p[i];
+  if (c < 0x80)
+  {
+    return 1;
+  }
+  size_t len;
+  unsigned char lo = 0x80, hi = 0xBF; // allowed range of the second byte
+  if (c >= 0xC2 && c <= 0xDF)
+  {
+    len = 2;
+  }
+  else if (c >= 0xE0 && c <= 0xEF)
+  {
+    len = 3;
+    lo = c == 0xE0 ? 0xA0 : 0x80; // overlong
+    hi = c == 0xED ? 0x9F : 0xBF; // surrogates
+  }
+  else if (c >= 0xF0 && c <= 0xF4)
+  {
+    len = 4;
+    lo = c == 0xF0 ? 0x90 : 0x80; // overlong
+    hi = c == 0xF4 ? 0x8F : 0xBF; // above U+10FFFF
+  }
+  else
+  {
+    return 0;
+  }
+  if (n - i < len || p[i + 1] < lo || p[i + 1] > hi)
+  {
+    return 0;
+  }
+  for (size_t j = 2; j < len; ++j)
+  {
+    if ((p[i + j] & 0xC0) != 0x80)
+    {
+      return 0;
+    }
+  }
+  return len;
+}
+
+/** * vl_str_utf8_valid_scalar() - Whether [p, p + n) is valid UTF-8,
+      starting at index i.
+  */
+inline bool vl_str_utf8_valid_scalar (const char *p, size_t n, size_t i = 0)
+noexcept
+{
+  const unsigned char *u = reinterpret_cast<const unsigned char *> (p);
+  while (i < n)
+  {
+    size_t len = vl_str_utf8_char (u, i, n);
+    if (len == 0)
+    {
+      return false;
+    }
+    i += len;
+  }
+  return true;
+}
+
+#if defined(VL_STRING_X86)
+//<--------SSE2 Kernels---------->
+inline size_t vl_str_find_char_sse2 (const char *p, size_t n, char c)
+noexcept
+{
+  const __m128i needle = _mm_set1_epi8 (c);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i block = _mm_loadu_si128 ((const __m128i *) (p + i));
+    unsigned mask = (unsigned) _mm_movemask_epi8 (_mm_cmpeq_epi8 (block,
+                                                                  needle));
+    if (mask != 0)
+    {
+      return i + (size_t) __builtin_ctz (mask);
+    }
+  }
+  return i + vl_str_find_char_scalar (p + i, n - i, c);
+}
+
+/** * vl_str_find_sse2() - Substring search: a block is checked against
+      the first and the last char of the needle at once, and only the
+      positions where both match are compared in full. Needs m >= 2.
+  */
+inline size_t vl_str_find_sse2 (const char *p, size_t n, const char *s,
+                                size_t m) noexcept
+{
+  const __m128i first = _mm_set1_epi8 (s[0]);
+  const __m128i last = _mm_set1_epi8 (s[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16)
+  {
+    __m128i block_first = _mm_loadu_si128 ((const __m128i *) (p + i));
+    __m128i block_last = _mm_loadu_si128 ((const __m128i *) (p + i + m
+                                                               - 1));
+    unsigned mask = (unsigned) _mm_movemask_epi8 (
+        _mm_and_si128 (_mm_cmpeq_epi8 (block_first, first),
+                       _mm_cmpeq_epi8 (block_last, last)));
+    while (mask != 0)
+    {
+      size_t at = i + (size_t) __builtin_ctz (mask);
+      if (std::memcmp (p + at + 1, s + 1, m - 2) == 0)
+      {
+        return at;
+      }
+      mask &= mask - 1;
+    }
+  }
+  std::string_view tail (p + i, n - i);
+  size_t rest = tail.find (std::string_view (s, m));
+  return rest == std::string_view::npos ? n : i + rest;
+}
+
+/** * vl_str_find_first_of_sse2() - Sets of up to 16 chars: one compare
+      per char of the set for every 16 byte block.
+  */
+inline size_t vl_str_find_first_of_sse2 (const char *p, size_t n,
+                                         const char *set, size_t k) noexcept
+{
+  if (k > 16)
+  {
+    return vl_str_find_first_of_scalar (p, n, set, k);
+  }
+  __m128i needles[16];
+  for (size_t j = 0; j < k; ++j)
+  {
+    needles[j] = _mm_set1_epi8 (set[j]);
+  }
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i block = _mm_loadu_si128 ((const __m128i *) (p + i));
+    __m128i hits = _mm_setzero_si128 ();
+    for (size_t j = 0; j < k; ++j)
+    {
+      hits = _mm_or_si128 (hits, _mm_cmpeq_epi8 (block, needles[j]));
+    }
+    unsigned mask = (unsigned) _mm_movemask_epi8 (hits);
+    if (mask != 0)
+    {
+      return i + (size_t) __builtin_ctz (mask);
+    }
+  }
+  return i + vl_str_find_first_of_scalar (p + i, n - i, set, k);
+}
+
+inline void vl_str_ascii_case_sse2 (char *p, size_t n, char lo, char hi,
+                                    char delta) noexcept
+{
+  const __m128i below = _mm_set1_epi8 ((char) (lo - 1));
+  const __m128i above = _mm_set1_epi8 ((char) (hi + 1));
+  const __m128i add = _mm_set1_epi8 (delta);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i block = _mm_loadu_si128 ((const __m128i *) (p + i));
+    __m128i in_range = _mm_and_si128 (_mm_cmpgt_epi8 (block, below),
+                                      _mm_cmpgt_epi8 (above, block));
+    block = _mm_add_epi8 (block, _mm_and_si128 (in_range, add));
+    _mm_storeu_si128 ((__m128i *) (p + i), block);
+  }
+  vl_str_ascii_case_scalar (p + i, n - i, lo, hi, delta);
+}
+
+/** * vl_str_utf8_valid_sse2() - Skips all-ASCII 16 byte blocks and
+      checks the multibyte sequences with the scalar code.
+  */
+inline bool vl_str_utf8_valid_sse2 (const char *p, size_t n) noexcept
+{
+  const unsigned char *u = reinterpret_cast<const unsigned char *> (p);
+  size_t i = 0;
+  while (i + 16 <= n)
+  {
+    __m128i block = _mm_loadu_si128 ((const __m128i *) (p + i));
+    if (_mm_movemask_epi8 (block) == 0)
+    {
+      i += 16;
+      continue;
+    }
+    for (size_t end = i + 16; i < end;)
+    {
+      size_t len = vl_str_utf8_char (u, i, n);
+      if (len == 0)
+      {
+        return false;
+      }
+      i += len;
+    }
+  }
+  return vl_str_utf8_valid_scalar (p, n, i);
+}
+
+//<--------AVX2 Kernels---------->
+VL_TARGET_AVX2
+inline size_t vl_str_find_char_avx2 (const char *p, size_t n, char c)
+noexcept
+{
+  const __m256i needle = _mm256_set1_epi8 (c);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32)
+  {
+    __m256i block = _mm256_loadu_si256 ((const __m256i *) (p + i));
+    unsigned mask = (unsigned) _mm256_movemask_epi8 (
+        _mm256_cmpeq_epi8 (block, needle));
+    if (mask != 0)
+    {
+      return i + (size_t) __builtin_ctz (mask);
+    }
+  }
+  return i + vl_str_find_char_sse2 (p + i, n - i, c);
+}
+
+VL_TARGET_AVX2
+inline size_t vl_str_find_avx2 (const char *p, size_t n, const char *s,
+                                size_t m) noexcept
+{
+  const __m256i first = _mm256_set1_epi8 (s[0]);
+  const __m256i last = _mm256_set1_epi8 (s[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 32 <= n; i += 32)
+  {
+    __m256i block_first = _mm256_loadu_si256 ((const __m256i *) (p + i));
+    __m256i block_last = _mm256_loadu_si256 ((const __m256i *) (p + i + m
+                                                                  - 1));
+    unsigned mask = (unsigned) _mm256_movemask_epi8 (
+        _mm256_and_si256 (_mm256_cmpeq_epi8 (block_first, first),
+                          _mm256_cmpeq_epi8 (block_last, last)));
+    while (mask != 0)
+    {
+      size_t at = i + (size_t) __builtin_ctz (mask);
+      if (std::memcmp (p + at + 1, s + 1, m - 2) == 0)
+      {
+        return at;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return i + vl_str_find_sse2 (p + i, n - i, s, m);
+}
+
+VL_TARGET_AVX2
+inline size_t vl_str_find_first_of_avx2 (const char *p, size_t n,
+                                         const char *set, size_t k) noexcept
+{
+  if (k > 16)
+  {
+    return vl_str_find_first_of_scalar (p, n, set, k);
+  }
+  __m256i needles[16];
+  for (size_t j = 0; j < k; ++j)
+  {
+    needles[j] = _mm256_set1_epi8 (set[j]);
+  }
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32)
+  {
+    __m256i block = _mm256_loadu_si256 ((const __m256i *) (p + i));
+    __m256i hits = _mm256_setzero_si256 ();
+    for (size_t j = 0; j < k; ++j)
+    {
+      hits = _mm256_or_si256 (hits, _mm256_cmpeq_epi8 (block, needles[j]));
+    }
+    unsigned mask = (unsigned) _mm256_movemask_epi8 (hits);
+    if (mask != 0)
+    {
+      return i + (size_t) __builtin_ctz (mask);
+    }
+  }
+  return i + vl_str_find_first_of_sse2 (p + i, n - i, set, k);
+}
+
+VL_TARGET_AVX2
+inline void vl_str_ascii_case_avx2 (char *p, size_t n, char lo, char hi,
+                                    char delta) noexcept
+{
+  const __m256i below = _mm256_set1_epi8 ((char) (lo - 1));
+  const __m256i above = _mm256_set1_epi8 ((char) (hi + 1));
+  const __m256i add = _mm256_set1_epi8 (delta);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32)
+  {
+    __m256i block = _mm256_loadu_si256 ((const __m256i *) (p + i));
+    __m256i in_range = _mm256_and_si256 (_mm256_cmpgt_epi8 (block, below),
+                                         _mm256_cmpgt_epi8 (above, block));
+    block = _mm256_add_epi8 (block, _mm256_and_si256 (in_range, add));
+    _mm256_storeu_si256 ((__m256i *) (p + i), block);
+  }
+  vl_str_ascii_case_sse2 (p + i, n - i, lo, hi, delta);
+}
+
+VL_TARGET_AVX2
+inline bool vl_str_utf8_valid_avx2 (const char *p, size_t n) noexcept
+{
+  const unsigned char *u = reinterpret_cast<const unsigned char *> (p);
+  size_t i = 0;
+  while (i + 32 <= n)
+  {
+    __m256i block = _mm256_loadu_si256 ((const __m256i *) (p + i));
+    if (_mm256_movemask_epi8 (block) == 0)
+    {
+      i += 32;
+      continue;
+    }
+    for (size_t end = i + 32; i < end;)
+    {
+      size_t len = vl_str_utf8_char (u, i, n);
+      if (len == 0)
+      {
+        return false;
+      }
+      i += len;
+    }
+  }
+  return vl_str_utf8_valid_scalar (p, n, i);
+}
+
+/** * vl_str_cpu_has_avx2() - Whether the CPU running the program has
+      AVX2 (checked once).
+  */
+inline bool vl_str_cpu_has_avx2 () noexcept
+{
+#if defined(__AVX2__)
+  return true;
+#else
+  static const bool has_avx2 = __builtin_cpu_supports ("avx2");
+  return has_avx2;
+#endif
+}
+
+inline bool &vl_str_avx2_switch () noexcept
+{
+  static bool use_avx2 = vl_str_cpu_has_avx2 ();
+  return use_avx2;
+}
+
+/** * vl_str_has_avx2() - Whether the dispatchers use the AVX2 kernels:
+      when the CPU has AVX2, unless turned off by vl_str_set_avx2().
+  */
+inline bool vl_str_has_avx2 () noexcept
+{
+  return vl_str_avx2_switch ();
+}
+
+/** * vl_str_set_avx2() - Turns the AVX2 kernels off (SSE2 is used) or
+      back on (only if the CPU has AVX2), e.g. to test or benchmark both.
+      Not thread-safe: call it while no other thread uses the kernels.
+      return whether the AVX2 kernels are now used.
+  */
+inline bool vl_str_set_avx2 (bool on) noexcept
+{
+  vl_str_avx2_switch () = on && vl_str_cpu_has_avx2 ();
+  return vl_str_avx2_switch ();
+}
+#endif
+
+//<--------Dispatch---------->
+/** * vl_str_find_char() - Index of the first c in [p, p + n), or n.
+      Runtime complexity: O(n).
+  */
+inline size_t vl_str_find_char (const char *p, size_t n, char c) noexcept
+{
+#if defined(VL_STRING_X86)
+  if (vl_str_has_avx2 ())
+  {
+    return vl_str_find_char_avx2 (p, n, c);
+  }
+  return vl_str_find_char_sse2 (p, n, c);
+#else
+  return vl_str_find_char_scalar (p, n, c);
+#endif
+}
+
+/** * vl_str_find() - Index of the first occurrence of [s, s + m) in
+      [p, p + n), or n.
+      Runtime complexity: O(n * m) worst case, O(n) typical.
+  */
+inline size_t vl_str_find (const char *p, size_t n, const char *s, size_t m)
+noexcept
+{
+  if (m == 0)
+  {
+    return 0;
+  }
+  if (m > n)
+  {
+    return n;
+  }
+  if (m == 1)
+  {
+    return vl_str_find_char (p, n, s[0]);
+  }
+#if defined(VL_STRING_X86)
+  if (vl_str_has_avx2 ())
+  {
+    return vl_str_find_avx2 (p, n, s, m);
+  }
+  return vl_str_find_sse2 (p, n, s, m);
+#else
+  size_t at = std::string_view (p, n).find (std::string_view (s, m));
+  return at == std::string_view::npos ? n : at;
+#endif
+}
+
+/** * vl_str_find_first_of() - Index of the first char of [p, p + n) that
+      is in [set, set + k), or n.
+      Runtime complexity: O(n * k) for k <= 16, O(n + k) otherwise.
+  */
+inline size_t vl_str_find_first_of (const char *p, size_t n,
+                                    const char *set, size_t k) noexcept
+{
+#if defined(VL_STRING_X86)
+  if (vl_str_has_avx2 ())
+  {
+    return vl_str_find_first_of_avx2 (p, n, set, k);
+  }
+  return vl_str_find_first_of_sse2 (p, n, set, k);
+#else
+  return vl_str_find_first_of_scalar (p, n, set, k);
+#endif
+}
+
+/** * vl_str_ascii_case() - Adds delta to every char in [lo, hi].
+      Runtime complexity: O(n).
+  */
+inline void vl_str_ascii_case (char *p, size_t n, char lo, char hi,
+                               char delta) noexcept
+{
+#if defined(VL_STRING_X86)
+  if (vl_str_has_avx2 ())
+  {
+    vl_str_ascii_case_avx2 (p, n, lo, hi, delta);
+    return;
+  }
+  vl_str_ascii_case_sse2 (p, n, lo, hi, delta);
+#else
+  vl_str_ascii_case_scalar (p, n, lo, hi, delta);
+#endif
+}
+
+/** * vl_str_utf8_valid() - Whether [p, p + n) is valid UTF-8.
+      Runtime complexity: O(n).
+  */
+inline bool vl_str_utf8_valid (const char *p, size_t n) noexcept
+{
+#if defined(VL_STRING_X86)
+  if (vl_str_has_avx2 ())
+  {
+    return vl_str_utf8_valid_avx2 (p, n);
+  }
+  return vl_str_utf8_valid_sse2 (p, n);
+#else
+  return vl_str_utf8_valid_scalar (p, n);
+#endif
+}
+
+/** * vl_str_is_space() - Whether c is ASCII white space (" \t\n\v\f\r").
+  */
+inline bool vl_str_is_space (char c) noexcept
+{
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+//<--------vl_string---------->
+/**
+ * vl_string - A vl_vector<char> with string operations. The size does
+ * not include a null terminator.
+ */
+template<size_t static_capacity = STATIC_CAPACITY>
+class vl_string : public vl_vector<char, static_capacity>
+{
+ public:
+  static constexpr size_t npos = (size_t) -1;
+
+  //<--------Constructors---------->
+
+  /**  * Default constructor, new empty string.
+         Runtime complexity: O(1).
+   */
+  vl_string () = default;
+
+  /**  * Constructor from a null terminated string. Not explicit, so
+         vl_string<> s = "text"; works.
+         Runtime complexity: O(n).
+   */
+  vl_string (const char *s) : vl_string (std::string_view (s))
+  {
+  }
+
+  /**  * Constructor from a string view (std::string converts to it).
+         Runtime complexity: O(n).
+   */
+  vl_string (std::string_view s)
+  {
+    append (s);
+  }
+
+  /**  * Constructor from the chars of a vl_vector of any static capacity.
+         Runtime complexity: O(n).
+   */
+  explicit vl_string (const vl_vector_ref<char> &v)
+      : vl_vector<char, static_capacity> (v)
+  {
+  }
+
+//<--------Conversions---------->
+
+/** * view() - The chars as a std::string_view.
+      Runtime complexity: O(1).
+  */
+  std::string_view view () const noexcept
+  {
+    return std::string_view (this->data (), this->size ());
+  }
+
+  operator std::string_view () const noexcept
+  {
+    return view ();
+  }
+
+  operator std::string () const
+  {
+    return std::string (this->data (), this->size ());
+  }
+
+//<--------Appending---------->
+
+/** * append() - Appends the chars of s, growing at most once.
+      Runtime complexity: O(n).
+  */
+  vl_string &append (std::string_view s)
+  {
+    vl_append_chars (*this, s);
+    return *this;
+  }
+
+  vl_string &operator+= (std::string_view s)
+  {
+    return append (s);
+  }
+
+  vl_string &operator+= (const char *s)
+  {
+    return append (std::string_view (s));
+  }
+
+  vl_string &operator+= (char c)
+  {
+    this->push_back (c);
+    return *this;
+  }
+
+//<--------Numbers---------->
+
+/** * append_int() - Appends value written in base, straight into the
+      buffer (see vl_format.hpp).
+      Runtime complexity: O(number of digits).
+  */
+  template<typename T>
+  vl_string &append_int (T value, int base = 10)
+  {
+    vl_append_int (*this, value, base);
+    return *this;
+  }
+
+/** * append_float() - Appends the shortest text that reads back to
+      exactly value.
+      Runtime complexity: O(number of digits).
+  */
+  template<typename T>
+  vl_string &append_float (T value)
+  {
+    vl_append_float (*this, value);
+    return *this;
+  }
+
+/** * append_float() - Appends value in the given format and precision.
+      Runtime complexity: O(number of digits).
+  */
+  template<typename T>
+  vl_string &append_float (T value, std::chars_format fmt,
+                           int precision = -1)
+  {
+    vl_append_float (*this, value, fmt, precision);
+    return *this;
+  }
+
+/** * append_format() - Appends fmt with its "{}" placeholders replaced
+      by args, e.g. s.append_format ("id={} t={:.3f}", id, t).
+      exception if fmt does not match args, the string is then unchanged.
+      Runtime complexity: O(length of the output).
+  */
+  template<typename... Args>
+  vl_string &append_format (std::string_view fmt, const Args &...args)
+  {
+    vl_append_format (*this, fmt, args...);
+    return *this;
+  }
+
+/** * parse_int() - Parses an integer from the chars [pos, pos + count),
+      storing the index after it in *end if end is not null.
+      exception if there is no number there or it does not fit in T.
+      Runtime complexity: O(number of digits).
+  */
+  template<typename T>
+  T parse_int (size_t pos = 0, size_t count = npos, size_t *end = nullptr,
+               int base = 10) const
+  {
+    return vl_parse_int<T> (*this, pos, count, end, base);
+  }
+
+/** * parse_float() - Parses a floating point number from the chars
+      [pos, pos + count), storing the index after it in *end if end is
+      not null.
+      exception if there is no number there or it does not fit in T.
+      Runtime complexity: O(number of digits).
+  */
+  template<typename T>
+  T parse_float (size_t pos = 0, size_t count = npos, size_t *end = nullptr,
+                 std::chars_format fmt = std::chars_format::general) const
+  {
+    return vl_parse_float<T> (*this, pos, count, end, fmt);
+  }
+
+//<--------Search---------->
+
+/** * find() - Index of the first c at or after pos, or npos.
+      Runtime complexity: O(n).
+  */
+  size_t find (char c, size_t pos = 0) const noexcept
+  {
+    if (pos >= this->size ())
+    {
+      return npos;
+    }
+    size_t at = vl_str_find_char (this->data () + pos, this->size () - pos,
+                                  c);
+    return at == this->size () - pos ? npos : pos + at;
+  }
+
+/** * find() - Index of the first occurrence of s at or after pos,
+      or npos.
+      Runtime complexity: O(n) typical.
+  */
+  size_t find (std::string_view s, size_t pos = 0) const noexcept
+  {
+    if (pos > this->size ())
+    {
+      return npos;
+    }
+    size_t n = this->size () - pos;
+    size_t at = vl_str_find (this->data () + pos, n, s.data (), s.size ());
+    return at == n && !s.empty () ? npos : pos + at;
+  }
+
+/** * find_first_of() - Index of the first char at or after pos that is
+      one of the chars of set, or npos.
+      Runtime complexity: O(n) for sets of up to 16 chars.
+  */
+  size_t find_first_of (std::string_view set, size_t pos = 0) const noexcept
+  {
+    if (pos >= this->size ())
+    {
+      return npos;
+    }
+    size_t n = this->size () - pos;
+    size_t at = vl_str_find_first_of (this->data () + pos, n, set.data (),
+                                      set.size ());
+    return at == n ? npos : pos + at;
+  }
+
+/** * split() - Appends to out a view of every piece between delimiters
+      (empty pieces included, so "a,,b" gives "a", "", "b").
+      Runtime complexity: O(n).
+  */
+  void split (char delim, vl_vector_ref<std::string_view> &out) const
+  {
+    const char *p = this->data ();
+    size_t n = this->size ();
+    size_t start = 0;
+    while (true)
+    {
+      size_t at = start + vl_str_find_char (p + start, n - start, delim);
+      out.push_back (std::string_view (p + start, at - start));
+      if (at == n)
+      {
+        return;
+      }
+      start = at + 1;
+    }
+  }
+
+/** * split() - The pieces between delimiters, as views into the string.
+      Runtime complexity: O(n).
+  */
+  vl_vector<std::string_view> split (char delim) const
+  {
+    vl_vector<std::string_view> out;
+    split (delim, out);
+    return out;
+  }
+
+//<--------Transformations---------->
+
+/** * to_lower() - Folds the ASCII letters to lower case, in place.
+      Runtime complexity: O(n).
+  */
+  vl_string &to_lower () noexcept
+  {
+    vl_str_ascii_case (this->data (), this->size (), 'A', 'Z', 'a' - 'A');
+    return *this;
+  }
+
+/** * to_upper() - Folds the ASCII letters to upper case, in place.
+      Runtime complexity: O(n).
+  */
+  vl_string &to_upper () noexcept
+  {
+    vl_str_ascii_case (this->data (), this->size (), 'a', 'z',
+                       (char) ('A' - 'a'));
+    return *this;
+  }
+
+/** * trim_view() - A view without the leading and trailing ASCII
+      white space.
+      Runtime complexity: O(number of white space chars trimmed).
+  */
+  std::string_view trim_view () const noexcept
+  {
+    const char *p = this->data ();
+    size_t begin = 0, end = this->size ();
+    while (begin < end && vl_str_is_space (p[begin]))
+    {
+      ++begin;
+    }
+    while (end > begin && vl_str_is_space (p[end - 1]))
+    {
+      --end;
+    }
+    return std::string_view (p + begin, end - begin);
+  }
+
+/** * trim() - Removes the leading and trailing ASCII white space,
+      in place.
+      Runtime complexity: O(n).
+  */
+  vl_string &trim () noexcept
+  {
+    std::string_view kept = trim_view ();
+    std::memmove (this->data (), kept.data (), kept.size ());
+    this->set_size (kept.size ());
+    return *this;
+  }
+
+/** * is_valid_utf8() - Whether the string is valid UTF-8.
+      Runtime complexity: O(n).
+  */
+  bool is_valid_utf8 () const noexcept
+  {
+    return vl_str_utf8_valid (this->data (), this->size ());
+  }
+
+//<--------Comparison---------->
+
+  friend bool operator== (const vl_string &lhs, const vl_string &rhs)
+  noexcept
+  {
+    return lhs.view () == rhs.view ();
+  }
+
+  friend bool operator!= (const vl_string &lhs, const vl_string &rhs)
+  noexcept
+  {
+    return lhs.view () != rhs.view ();
+  }
+
+  friend bool operator== (const vl_string &lhs, std::string_view rhs)
+  noexcept
+  {
+    return lhs.view () == rhs;
+  }
+
+  friend bool operator!= (const vl_string &lhs, std::string_view rhs)
+  noexcept
+  {
+    return lhs.view () != rhs;
+  }
+
+  friend bool operator== (const vl_string &lhs, const char *rhs) noexcept
+  {
+    return lhs.view () == rhs;
+  }
+
+  friend bool operator!= (const vl_string &lhs, const char *rhs) noexcept
+  {
+    return lhs.view () != rhs;
+  }
+};
+
+/**
+ * std::hash for vl_string, the same hash as for the equal
+ * vl_vector<char> and std::string_view (see vl_vector_hash).
+ */
+template<size_t static_capacity>
+struct std::hash<vl_string<static_capacity>> : vl_vector_hash<char>
+{
+};
+
+#endif //_VL_STRING_HPP_
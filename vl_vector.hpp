@@ -48,6 +48,61 @@
 // the number of elements to add. for more details,
 // see the implementation of the expand_capacity function.
 
+//--------Capacity-Erased Base-----------//
+// All the logic lives in vl_vector_ref<T>, which only knows the data
+// pointer, size and capacity (plus one word packing the static capacity,
+// the alignment and the heap block flags), so it is instantiated once
+// per T. vl_vector<T, N> only adds the stack buffer, which sits right
+// after that header, so the base finds it from 'this' (like LLVM's
+// SmallVectorImpl) and a pointer to it is not stored.
+// Functions can take a vl_vector_ref<T>& and accept any static capacity.
+// vl_vector_bytes<T, B> gives the static capacity as a byte budget.
+
+//--------File Descriptor I/O-----------//
+// For trivially copyable T, append_from_fd() reads straight into the
+// unused tail of the buffer and write_to_fd() writes the elements out,
+// without a scratch buffer or per-element push_back. readv_from_fd()
+// and writev_to_fd() do the same over a range of vectors with readv /
+// writev, IOV_MAX vectors per call. EINTR is retried. None of them ever
+// waits on a non-blocking fd: on EAGAIN they return what was done so
+// far, and the caller polls and calls again. The writes take the byte
+// offset to resume from, and the reads can keep an element cut off by
+// EAGAIN (in the unused capacity) for the next call to complete.
+
+//--------Hashing-----------//
+// std::hash<vl_vector<T, N>> hashes the contiguous bytes in one pass with
+// wyhash when T has unique object representations (integers, enums,
+// pointers, plain structs without padding), and mixes std::hash<T> of each
+// element otherwise. vl_vector_hash<T> / vl_vector_equal<T> are transparent,
+// so a std::basic_string_view<T> (or a std::span<const T> in C++20) can
+// probe an unordered container without building a vl_vector.
+
+//--------Alignment-----------//
+// The third template parameter sets the alignment of both the static
+// buffer and every heap block (through the aligned operator new).
+// It defaults to alignof(T); use 32 / 64 for aligned AVX loads, or
+// VL_CACHE_LINE_SIZE to keep per-thread vectors off a shared cache line.
+// data() tells the compiler about that alignment (assume_aligned).
+
+//--------Relocating Growth-----------//
+// For trivial T the heap block comes from malloc, so growth goes through
+// realloc (which can extend in place) and the malloc_usable_size slack is
+// used as extra capacity. Blocks of VL_MMAP_THRESHOLD bytes or more are
+// mapped with mmap instead, grown with mremap (pages are remapped, not
+// copied) and advised with MADV_HUGEPAGE to cut TLB misses.
+
+//--------Buffer Handoff-----------//
+// release() hands the heap block over as a vl_heap_buffer<T> (a unique_ptr
+// whose deleter knows how the block was allocated, plus size and
+// capacity), and adopt() takes over an external block with its own
+// deleter, so large payloads cross API boundaries without a copy.
+// The adopted deleter is kept in a heap record made by adopt(), which
+// the packed header word points to while the block is held, so adopting
+// costs nothing to the vectors that never do it.
+// A std::vector<T, vl_malloc_allocator<T>> of trivial T allocates its
+// buffer the way vl_vector does, so vl_vector takes that buffer over too.
+// Any other std::vector is moved element by element.
+
 //--------Time Complexity-----------//
 // Many operations of the vl_vector class, such as accessing elements
 // (operator[], at), adding elements (push_back), and removing elements
@@ -69,112 +124,230 @@
 
 //<------------------DEFINE & INCLUDES--------------------->
 #define STATIC_CAPACITY 16 // for not using magic numbers
+#define VL_CACHE_LINE_SIZE 64 // destructive interference size on x86/ARM
+#ifndef VL_MMAP_THRESHOLD // heap blocks from this size on use mmap/mremap
+#define VL_MMAP_THRESHOLD (size_t (32) << 20) // 32 MiB, SIZE_MAX disables
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h> // malloc_usable_size
+#endif
+#if defined(__linux__)
+#include <sys/mman.h> // mmap, mremap, madvise
+#include <unistd.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#define VL_VECTOR_FD_IO 1
+#include <cerrno>
+#include <climits> // IOV_MAX
+#include <poll.h>
+#include <sys/uio.h> // readv, writev
+#include <unistd.h>
+#endif
 //<-----------------------IMPLEMENTATION----------------------->
-template<typename T, size_t static_capacity = STATIC_CAPACITY>
-class vl_vector
+#if defined(VL_VECTOR_FD_IO)
+/** * vl_fd_readable() - Whether a read from fd would return at once (with
+      data, end-of-file or an error), checked by poll() with no wait.
+  */
+inline bool vl_fd_readable (int fd) noexcept
 {
- public:
-
-  //<--------Constructors and Destructor---------->
-
-  /**  * Default constructor, new empty vector.
-         not using allocation memory on the heap.
-         Runtime complexity: O(1).
-   */
-
-  vl_vector ()
-  {
-    v_size = 0;
-    v_capacity = static_capacity;
-    is_on_heap = false; // Start with stack memory
-  }
-
-/**  * Copy constructor.
-       Assumes that the other vector is with the same
-       static capacity.
-       Runtime complexity: O(n) - number of elements.
- */
-
-  vl_vector (const vl_vector<T,static_capacity> &other) // cannot modify the other vector.
+  pollfd pfd = {fd, POLLIN, 0};
+  return poll (&pfd, 1, 0) > 0;
+}
+
+/** * vl_fd_complete() - After 'bytes' bytes were read into buf, keeps
+      reading from fd until buf ends on a whole element of elem_size, or
+      a read hits end-of-file or fails (EAGAIN included: it never waits).
+      error is set to the errno of the failed read, 0 otherwise.
+      return the number of bytes now in buf.
+      Runtime complexity: O(elem_size).
+  */
+inline size_t vl_fd_complete (int fd, char *buf, size_t bytes,
+                              size_t elem_size, int &error) noexcept
+{
+  error = 0;
+  while (bytes % elem_size != 0)
   {
-    v_size = other.v_size;
-    v_capacity = other.v_capacity;
-    is_on_heap = other.is_on_heap;
-    if (is_on_heap)
+    ssize_t got = read (fd, buf + bytes, elem_size - bytes % elem_size);
+    if (got > 0)
     {
-      v_heap_data = new T[v_capacity];
-      std::copy (other.v_heap_data, other.v_heap_data + v_size, v_heap_data);
+      bytes += (size_t) got;
     }
-    else
+    else if (got == 0) // end-of-file
+    {
+      break;
+    }
+    else if (errno != EINTR)
     {
-      std::copy (other.v_stack_data,
-                 other.v_stack_data + v_size, v_stack_data);
+      error = errno;
+      break;
     }
   }
+  return bytes;
+}
+
+/** * vl_fd_whole() - Splits the bytes vl_fd_complete() left in a buffer
+      into whole elements and a cut off element. The cut off element is
+      kept (its size stored in *partial) when the read stopped on EAGAIN
+      and partial is not null; otherwise it is dropped.
+      return the bytes of whole elements, or -1 with errno set if there
+      are none and the read failed (EAGAIN when the element was kept).
+      Runtime complexity: O(1).
+  */
+inline ssize_t vl_fd_whole (size_t bytes, size_t elem_size, int error,
+                            size_t *partial) noexcept
+{
+  size_t cut = bytes % elem_size;
+  if (partial != nullptr)
+  {
+    bool again = error == EAGAIN || error == EWOULDBLOCK;
+    *partial = again ? cut : 0;
+  }
+  size_t whole = bytes - cut;
+  if (whole == 0 && error != 0)
+  {
+    errno = error;
+    return -1;
+  }
+  return (ssize_t) whole;
+}
+#endif
 
-/**  * Sequence based constructor.
-       Runtime complexity: O(n)- num of elements in the range [first, last).
+/**
+ * vl_heap_deleter - Frees a heap block released by a vl_vector: calls
+ * free_block, which knows how the block was allocated (malloc, mmap,
+ * aligned new, or the deleter it was adopted with).
  */
-  template<class ForwardIterator>
-  vl_vector (const ForwardIterator &first, const ForwardIterator &last)
+template<typename T>
+struct vl_heap_deleter
+{
+  using free_function = void (*) (T *p, size_t capacity, size_t alignment,
+                                  void *context) noexcept;
+
+  free_function free_block = nullptr;
+  size_t capacity = 0; // elements in the block
+  size_t alignment = alignof (T);
+  void *context = nullptr; // state of an adopted block's deleter
+
+  void operator() (T *p) const noexcept
   {
-    v_capacity = static_capacity;
-    v_size = 0;
-    is_on_heap = false;
-    size_t range = std::distance (first, last);
-    if (v_size + range > static_capacity)
-    {
-      expand_capacity (range);
-    }
-    for (ForwardIterator it = first; it != last; ++it)
+    if (p != nullptr && free_block != nullptr)
     {
-      push_back (*it);
+      free_block (p, capacity, alignment, context);
     }
   }
+};
 
-/**  * Single-value initialized constructor.
-       The choice not to mark it as explicit is
-       to enhance code readability and ease of use.
-       Not leading to unexpected behavior, as it offers a unique signature
-       not found in other constructors.
-       Runtime complexity: O(count) - number of elements with value v.
+/**
+ * vl_heap_buffer - A heap block taken out of a vl_vector by release():
+ * the first 'size' of its 'capacity' elements are the vector elements.
+ * The block only moves on together with its deleter: move the unique_ptr,
+ * hand it to a vector with adopt (std::move (b.data), b.size, b.capacity),
+ * or free it with data.get_deleter () (p) after data.release (). A block
+ * the vector had adopted is freed by the deleter it was adopted with,
+ * which lives in a record (the context) that only this call frees, so
+ * the pointer alone cannot be freed any other way.
+ */
+template<typename T>
+struct vl_heap_buffer
+{
+  std::unique_ptr<T[], vl_heap_deleter<T>> data;
+  size_t size = 0;
+  size_t capacity = 0;
+};
+
+/**
+ * vl_malloc_allocator - A std::allocator replacement that allocates with
+ * malloc, like vl_vector does for trivial T. A vl_vector constructed from
+ * a std::vector<T, vl_malloc_allocator<T>>&& takes its buffer over.
  */
-  vl_vector (size_t count, const T &v)
+template<typename T>
+struct vl_malloc_allocator
+{
+  static_assert (alignof (T) <= alignof (std::max_align_t),
+                 "malloc does not align T");
+  using value_type = T;
+
+  vl_malloc_allocator () noexcept = default;
+
+  template<typename U>
+  vl_malloc_allocator (const vl_malloc_allocator<U> &) noexcept
   {
-    v_capacity = static_capacity;
-    v_size = 0;
-    is_on_heap = false;
-    for (size_t i = 0; i < count; ++i)
-    {
-      push_back (v);
-    }
   }
 
-/**  * initializer_list Constructor.
-       convenient way to initialize the vector with a known set of values.
-       Runtime complexity: O(n) - number of elements in in_l.
- */
-  vl_vector (std::initializer_list<T> in_l)
+  T *allocate (size_t n)
   {
-    v_capacity = static_capacity;
-    v_size = 0;
-    is_on_heap = false;
-    for (const T &value: in_l)  // iterates over elements in "in_l".
+    void *p = std::malloc (n * sizeof (T));
+    if (p == nullptr)
     {
-      push_back (value);
+      throw std::bad_alloc ();
     }
+    return static_cast<T *> (p);
   }
 
-/**  * Destructor.
-       Runtime complexity: O(1).
- */
-  ~vl_vector ()
+/** * deallocate() - Frees p, unless a vl_vector on this thread has just
+      taken it over (see stolen()).
+  */
+  void deallocate (T *p, size_t) noexcept
   {
-    if (is_on_heap)
+    if (p == stolen ())
     {
-      delete[] v_heap_data;// Memory erase - an array of elements.
+      stolen () = nullptr;
+      return;
     }
+    std::free (p);
+  }
+
+/** * stolen() - The block a vl_vector is taking over, which the emptied
+      std::vector must not free.
+  */
+  static T *&stolen () noexcept
+  {
+    static thread_local T *block = nullptr;
+    return block;
+  }
+
+  template<typename U>
+  bool operator== (const vl_malloc_allocator<U> &) const noexcept
+  {
+    return true;
+  }
+
+  template<typename U>
+  bool operator!= (const vl_malloc_allocator<U> &) const noexcept
+  {
+    return false;
   }
+};
+
+/**
+ * vl_vector_ref - The capacity-independent part of vl_vector: the data
+ * pointer, size and capacity, and every operation on them. It is compiled
+ * once per T, whatever the static capacities in use, and a function that
+ * takes a vl_vector_ref<T>& accepts (and can grow) any vl_vector<T, N>.
+ */
+template<typename T>
+class vl_vector_ref
+{
+ public:
+
 //  //<--------Iterators---------->
 
 /**
@@ -307,6 +480,43 @@ class vl_vector
     {
       return !(lhs == rhs);
     }
+
+    /**
+        operator[] - Subscript operator, *(it + n).
+     */
+    reference operator[] (difference_type n) const { return m_ptr[n]; }
+
+    /**
+        operator+ - Addition operator, n + it.
+     */
+    friend iterator operator+ (difference_type n, const iterator &it)
+    {
+      return it + n;
+    }
+
+    /**
+        operator<, operator>, operator<=, operator>= - Ordering operators,
+        required by std::sort and other random access algorithms.
+     */
+    friend bool operator< (const iterator &lhs, const iterator &rhs)
+    {
+      return lhs.m_ptr < rhs.m_ptr;
+    }
+
+    friend bool operator> (const iterator &lhs, const iterator &rhs)
+    {
+      return rhs < lhs;
+    }
+
+    friend bool operator<= (const iterator &lhs, const iterator &rhs)
+    {
+      return !(rhs < lhs);
+    }
+
+    friend bool operator>= (const iterator &lhs, const iterator &rhs)
+    {
+      return !(lhs < rhs);
+    }
    private:
     pointer m_ptr;
 
@@ -421,7 +631,7 @@ class vl_vector
     /**
        operator- - Subtraction operator.
     */
-    difference_type operator- (const iterator &rhs) const
+    difference_type operator- (const const_iterator &rhs) const
     {
       return m_ptr - rhs.m_ptr;
     }
@@ -459,6 +669,43 @@ class vl_vector
     {
       return !(lhs == rhs);
     }
+
+    /**
+        operator[] - Subscript operator, *(it + n).
+     */
+    reference operator[] (difference_type n) const { return m_ptr[n]; }
+
+    /**
+        operator+ - Addition operator, n + it.
+     */
+    friend const_iterator operator+ (difference_type n, const const_iterator &it)
+    {
+      return it + n;
+    }
+
+    /**
+        operator<, operator>, operator<=, operator>= - Ordering operators,
+        required by std::sort and other random access algorithms.
+     */
+    friend bool operator< (const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return lhs.m_ptr < rhs.m_ptr;
+    }
+
+    friend bool operator> (const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return rhs < lhs;
+    }
+
+    friend bool operator<= (const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return !(rhs < lhs);
+    }
+
+    friend bool operator>= (const const_iterator &lhs, const const_iterator &rhs)
+    {
+      return !(lhs < rhs);
+    }
    private:
     pointer m_ptr;
   };
@@ -562,14 +809,7 @@ class vl_vector
     {
       throw std::out_of_range ("Index out of range");
     }
-    if (is_on_heap)
-    {
-      return v_heap_data[index];
-    }
-    else
-    {
-      return v_stack_data[index];
-    }
+    return v_data[index];
   }
 
 /** * at() - const version of the at() function.
@@ -582,14 +822,7 @@ class vl_vector
     {
       throw std::out_of_range ("Index out of range");
     }
-    if (is_on_heap)
-    {
-      return v_heap_data[index];
-    }
-    else
-    {
-      return v_stack_data[index];
-    }
+    return v_data[index];
   }
 
 /** * push_back() - Adds an element to the end.
@@ -602,14 +835,7 @@ class vl_vector
     {
       expand_capacity (1);
     }
-    if (is_on_heap)
-    {
-      v_heap_data[v_size] = value;
-    }
-    else
-    {
-      v_stack_data[v_size] = value;
-    }
+    v_data[v_size] = value;
     ++v_size;
   }
 
@@ -688,19 +914,16 @@ class vl_vector
       --v_size; // Decrement the size to remove the last element
 
       // Check if the vector is currently using dynamic memory allocation
-      if (is_on_heap)
+      if (is_on_heap ())
       {
         // Check if the size is back within the static capacity
-        if (v_size <= static_capacity)
+        if (v_size <= stack_capacity ())
         {
-          T temp_data[static_capacity]; // Create temporary array on stack
-          std::copy (v_heap_data, v_heap_data
-                                  + v_size, temp_data); //dynamic to stack
-          delete[] v_heap_data; // deleted the dynamically allocated memory
-          std::copy (temp_data, temp_data
-                                + v_size, v_stack_data); // temp to stack
-          v_capacity = static_capacity; // Reset capacity to static capacity
-          is_on_heap = false; // Update the flag to indicate stack memory
+          T *stack = stack_data ();
+          std::copy (v_data, v_data + v_size, stack); //heap to stack
+          free_heap ();
+          v_data = stack;
+          v_capacity = stack_capacity (); // Reset capacity to static one
         }
       }
     }
@@ -746,32 +969,63 @@ class vl_vector
   */
   void clear () noexcept
   {
-    if (is_on_heap)
+    if (is_on_heap ())
     {
-      delete[] v_heap_data; // deleted the dynamic memory
-      v_heap_data = nullptr;
-      is_on_heap = false; // Update the flag to indicate stack memory
-      v_capacity = static_capacity; // Reset the capacity to static capacity
+      free_heap ();
+      v_data = stack_data ();
+      v_capacity = stack_capacity (); // Reset the capacity to static capacity
     }
     v_size = 0; // Reset the size to zero
   }
 
-/** * data() - Returns a direct pointer to the memory array
-      used by the vector now. (Stack or Heap)
-      Runtime complexity: O(1).
+/** * reserve() - Makes room for at least n elements, so that
+      the vector grows at most once while it is filled up to n.
+      Like std::vector::reserve, it asks for exactly n (the block may
+      still come with some slack, see usable_capacity()).
+      Runtime complexity: O(n) if the vector grows, O(1) otherwise.
   */
-  T *data () noexcept
+  void reserve (size_t n)
   {
-    if (is_on_heap)
+    if (n > v_capacity)
     {
-      return v_heap_data;
+      grow_to (n);
     }
-    else
+  }
+
+/** * reserve_more() - Makes room for k more elements ahead of an append:
+      exactly size() + k if that is all the vector ever grows to, and at
+      least 1.5 times the capacity when it grows again, so repeated
+      appends stay amortized O(1) per element.
+      Runtime complexity: O(n) if the vector grows, O(1) otherwise.
+  */
+  void reserve_more (size_t k)
+  {
+    if (v_size + k > v_capacity)
     {
-      return v_stack_data;
+      size_t n = v_size + k;
+      grow_to (is_on_heap () ? std::max (n, v_capacity + v_capacity / 2) : n);
     }
   }
 
+/** * set_size() - Sets the size to n (at most capacity()) without
+      touching the elements, after they were written directly into
+      the buffer through data(), e.g. by read() or std::to_chars.
+      Runtime complexity: O(1).
+  */
+  void set_size (size_t n) noexcept
+  {
+    v_size = n;
+  }
+
+/** * data() - Returns a direct pointer to the memory array
+      used by the vector now. (Stack or Heap)
+      Runtime complexity: O(1).
+  */
+  T *data () noexcept
+  {
+    return v_data;
+  }
+
   // By providing both versions (data) , we allow non-const access only when
   // explicitly requested (via the non-const version of data()).
   // We ensure that const objects remain immutable by providing
@@ -785,43 +1039,36 @@ class vl_vector
   */
   const T *data () const noexcept
   {
-    if (is_on_heap)
-    {
-      return v_heap_data;
-    }
-    else
-    {
-      return v_stack_data;
-    }
+    return v_data;
   }
 
 
 //<--------Operators---------->
 /** * operator= - Copy assignment operator.
+      The other vector may have any static capacity; the elements stay
+      on the stack when they fit in this vector's static capacity.
       Runtime complexity: O(n).
   */
-  vl_vector &operator= (const vl_vector &other) noexcept
+  vl_vector_ref &operator= (const vl_vector_ref &other) noexcept
   {
     if (this != &other) // Check for self-assignment
     {
-      if (is_on_heap)
-      {
-        delete[] v_heap_data; // Deallocate the old heap memory
-      }
-      v_size = other.v_size;
-      v_capacity = other.v_capacity;
-      is_on_heap = other.is_on_heap;
-      if (is_on_heap) // Check if the other vector is using heap memory
+      if (is_on_heap ())
       {
-        v_heap_data = new T[v_capacity];
-        std::copy (other.v_heap_data,
-                   other.v_heap_data + v_size, v_heap_data);
+        free_heap (); // old memory
       }
-      else
+      v_data = stack_data ();
+      v_capacity = stack_capacity ();
+      if (other.v_size > v_capacity) // Check if the elements need heap memory
       {
-        std::copy (other.v_stack_data,
-                   other.v_stack_data + v_size, v_stack_data);
+        size_t capacity = other.v_capacity;
+        bool mapped;
+        v_data = allocate_heap (capacity, mapped);
+        v_capacity = capacity;
+        set_mapped (mapped);
       }
+      v_size = other.v_size;
+      std::copy (other.v_data, other.v_data + v_size, v_data);
     }
     return *this;
   }
@@ -831,14 +1078,7 @@ class vl_vector
   */
   T &operator[] (size_t index) noexcept
   {
-    if (is_on_heap)
-    {
-      return v_heap_data[index];
-    }
-    else
-    {
-      return v_stack_data[index];
-    }
+    return v_data[index];
   }
 
 /** * operator[] - const version of the operator[].
@@ -846,20 +1086,13 @@ class vl_vector
   */
   const T &operator[] (size_t index) const
   {
-    if (is_on_heap)
-    {
-      return v_heap_data[index];
-    }
-    else
-    {
-      return v_stack_data[index];
-    }
+    return v_data[index];
   }
 
 /** * operator== - Compares two vectors for equality.
       Runtime complexity: O(n).
   */
-  bool operator== (const vl_vector &other) const
+  bool operator== (const vl_vector_ref &other) const
   {
     if (v_size != other.v_size)
     {
@@ -878,62 +1111,1230 @@ class vl_vector
 /** * operator!= - Compares two vectors for inequality.
       Runtime complexity: O(n).
   */
-  bool operator!= (const vl_vector &other) const
+  bool operator!= (const vl_vector_ref &other) const
   {
     return !(*this == other);
   }
 
- protected:
-  size_t v_size;
-  size_t v_capacity;
-  T v_stack_data[static_capacity]; // Fixed-size array stored on the stack
-  T *v_heap_data = nullptr; // Pointer to dynamic memory
-  bool is_on_heap; // Flag to indicate whether the vec using dynamic memory.
+//<--------Buffer Handoff---------->
+/** * release() - Gives up the heap block: the caller gets it with the
+      size, the capacity and a deleter that frees it the right way (and
+      must go wherever the block goes, see vl_heap_buffer), and the
+      vector is left empty on the stack. Elements on the stack are first
+      moved to a new heap block of size elements.
+      Runtime complexity: O(1) on the heap, O(n) on the stack.
+  */
+  vl_heap_buffer<T> release ()
+  {
+    vl_heap_buffer<T> out;
+    if (!is_on_heap ())
+    {
+      if (v_size == 0)
+      {
+        return out;
+      }
+      size_t n = v_size;
+      bool mapped;
+      T *p = allocate_heap (n, mapped);
+      std::copy (v_data, v_data + v_size, p);
+      v_data = p;
+      v_capacity = n;
+      set_mapped (mapped);
+    }
+    out.data = std::unique_ptr<T[], vl_heap_deleter<T>> (v_data,
+                                                         heap_deleter ());
+    out.size = v_size;
+    out.capacity = v_capacity;
+    v_info = layout (); // the deleter of out owns an adopted record now
+    v_data = stack_data ();
+    v_size = 0;
+    v_capacity = stack_capacity ();
+    return out;
+  }
 
+/** * adopt() - Takes over the block p, which holds size elements and
+      room for capacity, in place of the current elements. deleter (p)
+      is called when the vector frees the block. For non-trivial T only
+      the size constructed elements are used, the capacity is ignored.
+      exception if p is null, not aligned for this vector, or capacity
+      is smaller than size; the vector is then unchanged.
+      Runtime complexity: O(1) (plus freeing the current heap block).
+  */
+  template<class Deleter>
+  void adopt (T *p, size_t size, size_t capacity, Deleter deleter)
+  {
+    if (p == nullptr || capacity < size
+        || reinterpret_cast<uintptr_t> (p) % block_alignment () != 0)
+    {
+      throw std::invalid_argument ("Bad block to adopt");
+    }
+    adopted_record *record = new adopted_deleter<Deleter> {
+        {&free_adopted_block<Deleter>, 0}, std::move (deleter)};
+    if (is_on_heap ())
+    {
+      free_heap ();
+    }
+    record->layout = v_info;
+    v_data = p;
+    v_size = size;
+    v_capacity = trivially_relocatable ? capacity : size;
+    v_info = reinterpret_cast<uintptr_t> (record) | ADOPTED;
+  }
 
-/** * expand_capacity() - Expands the capacity of the vector.
-      Runtime complexity: O(n).
+/** * adopt() - Takes over the array owned by p (e.g. from new T[n]),
+      with its deleter.
+      Runtime complexity: O(1) (plus freeing the current heap block).
   */
+  template<class Deleter>
+  void adopt (std::unique_ptr<T[], Deleter> &&p, size_t size,
+              size_t capacity)
+  {
+    adopt (p.get (), size, capacity, p.get_deleter ());
+    p.release ();
+  }
 
-  void expand_capacity (size_t k)
+/** * steal() - Replaces the elements with those of other, leaving it
+      empty. A std::vector<T, vl_malloc_allocator<T>> of trivial T that
+      does not fit on the stack hands its buffer over as is; any other
+      std::vector is moved element by element.
+      Runtime complexity: O(1) when the buffer is taken over, else O(n).
+  */
+  template<class Allocator>
+  void steal (std::vector<T, Allocator> &&other)
   {
-    size_t new_capacity = cap_c (v_size, k, v_capacity);
-    T *new_data = new T[new_capacity];
-    if (is_on_heap)
+    if constexpr (trivially_relocatable
+                  && std::is_same<Allocator, vl_malloc_allocator<T>>::value)
     {
-      std::copy (v_heap_data, v_heap_data + v_size, new_data);
-      delete[] v_heap_data;
-      v_heap_data = nullptr;
+      if (use_malloc () && other.size () > stack_capacity ())
+      {
+        T *p = other.data ();
+        size_t size = other.size ();
+        size_t capacity = other.capacity ();
+        vl_malloc_allocator<T>::stolen () = p;
+        std::vector<T, Allocator> ().swap (other); // frees all but p
+        if (is_on_heap ())
+        {
+          free_heap ();
+        }
+        v_data = p;
+        v_size = size;
+        v_capacity = usable_capacity (p, capacity);
+        return;
+      }
     }
-    else
+    clear ();
+    reserve (other.size ());
+    std::move (other.begin (), other.end (), v_data);
+    v_size = other.size ();
+    other.clear ();
+  }
+
+#if defined(VL_VECTOR_FD_IO)
+//<--------File Descriptor I/O---------->
+/** * append_from_fd() - Reads up to max_bytes (rounded down to whole
+      elements) from fd straight into the end of the vector, growing it
+      at most once. Like read(), it returns after the first successful
+      read, except that a trailing partial element is completed first
+      if its bytes are ready (a partial element cut off by end-of-file
+      is dropped). It never waits: on a non-blocking fd, pass partial to
+      keep an element cut off by EAGAIN in the unused capacity, with
+      its byte count in *partial, for the next call to complete (start
+      with *partial = 0, and leave the vector alone in between); without
+      it such an element is dropped.
+      return the number of bytes appended, 0 at end-of-file, or -1 with
+      errno set (EAGAIN included) if nothing could be appended; EINVAL
+      if max_bytes is less than one element.
+      Runtime complexity: O(max_bytes).
+  */
+  ssize_t append_from_fd (int fd, size_t max_bytes,
+                          size_t *partial = nullptr)
+  {
+    static_assert (std::is_trivially_copyable<T>::value,
+                   "fd I/O needs a trivially copyable T");
+    size_t max_count = max_bytes / sizeof (T);
+    size_t held = partial != nullptr ? *partial : 0;
+    if (max_count == 0 || held >= sizeof (T))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+    size_t size = v_size;
+    size_t cut = held > 0 ? 1 : 0;
+    v_size += cut; // growing moves the cut off element too
+    reserve_more (max_count - cut);
+    v_size = size;
+    char *tail = reinterpret_cast<char *> (v_data + v_size);
+    ssize_t got;
+    do
+    {
+      got = read (fd, tail + held, max_count * sizeof (T) - held);
+    }
+    while (got < 0 && errno == EINTR);
+    if (got <= 0)
+    {
+      if (got == 0 && partial != nullptr)
+      {
+        *partial = 0; // dropped at end-of-file
+      }
+      return got;
+    }
+    int error;
+    size_t bytes = vl_fd_complete (fd, tail, held + (size_t) got,
+                                   sizeof (T), error);
+    ssize_t whole = vl_fd_whole (bytes, sizeof (T), error, partial);
+    if (whole > 0)
     {
-      std::copy (v_stack_data, v_stack_data + v_size, new_data);
+      v_size += (size_t) whole / sizeof (T);
     }
-    v_capacity = new_capacity;
-    is_on_heap = true;
-    v_heap_data = new_data;
+    return whole;
   }
-/** * cap_c() - Calculates the new capacity of the vector based on
-      the current size and the number of elements to add.
-      The function uses a formula that approximates
-      the optimal capacity for the vector.
-      Runtime complexity: O(1).
+
+/** * write_to_fd() - Writes the elements to fd, from byte 'offset' on,
+      retrying on partial writes and EINTR. It never waits: when a
+      non-blocking fd is full it returns early, and the caller polls for
+      POLLOUT and calls again with offset + the bytes written so far.
+      return the number of bytes written by this call (fewer than asked
+      if the fd filled up or a later write failed), or -1 with errno set
+      (EAGAIN included) if nothing could be written; EINVAL if offset is
+      past the end.
+      Runtime complexity: O(n).
   */
-  size_t cap_c (size_t size, size_t k, size_t C)
+  ssize_t write_to_fd (int fd, size_t offset = 0) const
   {
-    if (size + k <= C)
+    static_assert (std::is_trivially_copyable<T>::value,
+                   "fd I/O needs a trivially copyable T");
+    size_t bytes = v_size * sizeof (T);
+    if (offset > bytes)
     {
-      // If sum of current size and k is <= to the static capacity C,
-      // return C indicating we still in static memory.
-      return C;
+      errno = EINVAL;
+      return -1;
     }
-    else
+    const char *p = reinterpret_cast<const char *> (v_data) + offset;
+    size_t left = bytes - offset;
+    size_t done = 0;
+    while (left > 0)
     {
-      // If size + k exceeds C, calculate the dynamic memory capacity with
-      // a formula that approximates optimal: (size + k) * 3 / 2.
-      return ((size + k) * 3) / 2;
+      ssize_t put = write (fd, p, left);
+      if (put < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        return done > 0 ? (ssize_t) done : -1;
+      }
+      p += put;
+      left -= (size_t) put;
+      done += (size_t) put;
     }
+    return (ssize_t) done;
   }
+#endif
+
+ protected:
+/**  * Constructor for the derived vl_vector: an empty vector over its
+       stack buffer of static_capacity elements, which must follow this
+       header (see stack_data()). Heap blocks are aligned to 'alignment'
+       bytes.
+       Runtime complexity: O(1).
+ */
+  vl_vector_ref (size_t static_capacity, size_t alignment) noexcept
+  {
+    v_info = pack_layout (static_capacity, alignment);
+    v_data = stack_data (); // Start with stack memory
+    v_size = 0;
+    v_capacity = static_capacity;
+  }
+
+  // Copies go through operator=, which copies the elements only;
+  // the stack buffer belongs to the derived vl_vector.
+  vl_vector_ref (const vl_vector_ref &) = delete;
+
+/**  * Destructor. Not virtual, a vl_vector_ref is never deleted directly.
+       Runtime complexity: O(1).
+ */
+  ~vl_vector_ref ()
+  {
+    if (is_on_heap ())
+    {
+      free_heap (); // array.
+    }
+  }
+
+  T *v_data; // Current elements: the stack buffer or the heap block
+  size_t v_size;
+  size_t v_capacity;
+  // The static capacity, log2 of the alignment and the MAPPED flag (see
+  // pack_layout()), or, while a block is adopted, its adopted_record
+  // with the ADOPTED flag.
+  uintptr_t v_info;
+
+  static constexpr uintptr_t MAPPED = 1; // heap block obtained from mmap
+  static constexpr uintptr_t ADOPTED = 2; // v_info points to the record
+  static constexpr uintptr_t FLAGS = MAPPED | ADOPTED;
+  static constexpr unsigned ALIGN_SHIFT = 2; // 6 bits of log2 (alignment)
+  static constexpr unsigned CAPACITY_SHIFT = 8;
+
+  // The deleter of an adopted heap block, and the v_info it replaced.
+  struct adopted_record
+  {
+    typename vl_heap_deleter<T>::free_function free_block;
+    uintptr_t layout;
+  };
+  template<class Deleter>
+  struct adopted_deleter : adopted_record
+  {
+    Deleter deleter;
+  };
+  static_assert (alignof (adopted_record) > FLAGS,
+                 "the flags are kept in the low bits of the record address");
+
+/** * pack_layout() - The v_info of a vector with no heap block, for the
+      given static capacity and alignment (a power of two).
+      Runtime complexity: O(1).
+  */
+  static constexpr uintptr_t pack_layout (size_t static_capacity,
+                                          size_t alignment) noexcept
+  {
+    uintptr_t log2 = 0;
+    while ((size_t (1) << log2) < alignment)
+    {
+      ++log2;
+    }
+    return (uintptr_t) static_capacity << CAPACITY_SHIFT
+           | log2 << ALIGN_SHIFT;
+  }
+
+/** * layout() - v_info without the flags (of the adopted record, while a
+      block is adopted).
+      Runtime complexity: O(1).
+  */
+  uintptr_t layout () const noexcept
+  {
+    adopted_record *record = adopted ();
+    return (record != nullptr ? record->layout : v_info) & ~FLAGS;
+  }
+
+/** * stack_capacity() - The static capacity of the derived vl_vector.
+      Runtime complexity: O(1).
+  */
+  size_t stack_capacity () const noexcept
+  {
+    return (size_t) (layout () >> CAPACITY_SHIFT);
+  }
+
+/** * block_alignment() - The alignment of the stack buffer and of heap
+      blocks.
+      Runtime complexity: O(1).
+  */
+  size_t block_alignment () const noexcept
+  {
+    return size_t (1) << ((layout () >> ALIGN_SHIFT) & 63);
+  }
+
+/** * stack_data() - The stack buffer of the derived vl_vector, its first
+      member, which starts at the first block_alignment() boundary after
+      this header.
+      Runtime complexity: O(1).
+  */
+  T *stack_data () const noexcept
+  {
+    size_t a = block_alignment ();
+    size_t offset = (sizeof (vl_vector_ref) + a - 1) & ~(a - 1);
+    char *self = const_cast<char *> (reinterpret_cast<const char *> (this));
+    return reinterpret_cast<T *> (self + offset);
+  }
+
+/** * is_on_heap() - Whether the elements are in a heap block (adopted
+      blocks always are).
+      Runtime complexity: O(1).
+  */
+  bool is_on_heap () const noexcept
+  {
+    return (v_info & ADOPTED) != 0 || v_data != stack_data ();
+  }
+
+/** * is_mapped() - Whether the heap block was obtained from mmap.
+      Runtime complexity: O(1).
+  */
+  bool is_mapped () const noexcept
+  {
+    return (v_info & MAPPED) != 0;
+  }
+
+/** * set_mapped() - Records how the (not adopted) heap block was obtained.
+      Runtime complexity: O(1).
+  */
+  void set_mapped (bool mapped) noexcept
+  {
+    v_info = (v_info & ~MAPPED) | (mapped ? MAPPED : 0);
+  }
+
+/** * adopted() - The record of the adopted heap block, or null for no
+      block or a block we allocated.
+      Runtime complexity: O(1).
+  */
+  adopted_record *adopted () const noexcept
+  {
+    return (v_info & ADOPTED) != 0
+               ? reinterpret_cast<adopted_record *> (v_info & ~FLAGS)
+               : nullptr;
+  }
+
+  // Trivial elements may be moved with memcpy/realloc/mremap and need no
+  // construction, so their heap blocks come from malloc or mmap.
+  static constexpr bool trivially_relocatable = std::is_trivial<T>::value;
+
+/** * use_malloc() - Whether heap blocks come from malloc/realloc
+      (which only guarantee alignof(std::max_align_t)).
+  */
+  bool use_malloc () const noexcept
+  {
+    return trivially_relocatable
+           && block_alignment () <= alignof (std::max_align_t);
+  }
+
+/** * use_mmap() - Whether large heap blocks may come from mmap/mremap
+      (which guarantee page alignment).
+  */
+  bool use_mmap () const noexcept
+  {
+#if defined(__linux__)
+    return trivially_relocatable && block_alignment () <= 4096
+           && sizeof (T) <= 4096;
+#else
+    return false;
+#endif
+  }
+
+/** * expand_capacity() - Expands the capacity of the vector to make
+      room for k more elements, with the growth factor of cap_c().
+      Runtime complexity: O(n).
+  */
+
+  void expand_capacity (size_t k)
+  {
+    grow_to (cap_c (v_size, k, v_capacity));
+  }
+
+/** * grow_to() - Moves the elements to a heap block of (at least)
+      new_capacity elements.
+      Runtime complexity: O(n).
+  */
+  void grow_to (size_t new_capacity)
+  {
+    if constexpr (trivially_relocatable)
+    {
+      if (is_on_heap () && adopted () == nullptr) // adopted blocks
+      {                                              // are not ours to realloc
+        reallocate_heap (new_capacity);
+        return;
+      }
+    }
+    bool new_mapped;
+    T *new_data = allocate_heap (new_capacity, new_mapped);
+    std::copy (v_data, v_data + v_size, new_data);
+    if (is_on_heap ())
+    {
+      free_heap ();
+    }
+    v_capacity = new_capacity;
+    set_mapped (new_mapped);
+    v_data = new_data;
+  }
+
+/** * reallocate_heap() - Grows the heap block of a trivial T to hold at
+      least new_capacity elements, keeping the first v_size of them.
+      A mapped block is grown with mremap, a malloc block with realloc,
+      and a block that crosses VL_MMAP_THRESHOLD moves to a new mapping.
+      Runtime complexity: O(n) worst case, O(1) when extended in place.
+  */
+  void reallocate_heap (size_t new_capacity)
+  {
+#if defined(__linux__)
+    if (use_mmap ()
+        && (is_mapped () || new_capacity * sizeof (T) >= VL_MMAP_THRESHOLD))
+    {
+      size_t bytes = map_size (new_capacity * sizeof (T));
+      void *p;
+      if (is_mapped ())
+      {
+        p = mremap (v_data, map_size (v_capacity * sizeof (T)),
+                    bytes, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED)
+        {
+          throw std::bad_alloc ();
+        }
+        madvise (p, bytes, MADV_HUGEPAGE);
+      }
+      else
+      {
+        p = map_pages (bytes);
+        std::memcpy (p, v_data, v_size * sizeof (T));
+        deallocate_heap (v_data, v_capacity, false);
+        set_mapped (true);
+      }
+      v_data = static_cast<T *> (p);
+      v_capacity = bytes / sizeof (T);
+      return;
+    }
+#endif
+    if (use_malloc ())
+    {
+      void *p = std::realloc (v_data, new_capacity * sizeof (T));
+      if (p == nullptr)
+      {
+        throw std::bad_alloc ();
+      }
+      v_data = static_cast<T *> (p);
+      v_capacity = usable_capacity (p, new_capacity);
+      return;
+    }
+    bool new_mapped;
+    T *new_data = allocate_heap (new_capacity, new_mapped);
+    std::memcpy (new_data, v_data, v_size * sizeof (T));
+    deallocate_heap (v_data, v_capacity, is_mapped ());
+    v_data = new_data;
+    v_capacity = new_capacity;
+    set_mapped (new_mapped);
+  }
+
+/** * allocate_heap() - Allocates n default-initialized elements
+      (like new T[n]) on a block aligned to block_alignment().
+      For trivial T the block comes from mmap (at VL_MMAP_THRESHOLD bytes
+      and above, 'mapped' is set) or malloc, and n is raised to the real
+      size of the block.
+      Runtime complexity: O(n).
+  */
+  T *allocate_heap (size_t &n, bool &mapped) const
+  {
+    mapped = false;
+#if defined(__linux__)
+    if (use_mmap () && n * sizeof (T) >= VL_MMAP_THRESHOLD)
+    {
+      size_t bytes = map_size (n * sizeof (T));
+      n = bytes / sizeof (T);
+      mapped = true;
+      return static_cast<T *> (map_pages (bytes));
+    }
+#endif
+    if (use_malloc ())
+    {
+      void *p = std::malloc (n * sizeof (T));
+      if (p == nullptr)
+      {
+        throw std::bad_alloc ();
+      }
+      n = usable_capacity (p, n);
+      return static_cast<T *> (p);
+    }
+    void *raw = ::operator new (n * sizeof (T),
+                                std::align_val_t (block_alignment ()));
+    T *p = static_cast<T *> (raw);
+    try
+    {
+      std::uninitialized_default_construct_n (p, n);
+    }
+    catch (...)
+    {
+      ::operator delete (raw, std::align_val_t (block_alignment ()));
+      throw;
+    }
+    return p;
+  }
+
+/** * deallocate_heap() - Destroys and frees a block of n elements
+      returned by allocate_heap().
+      Runtime complexity: O(n).
+  */
+  void deallocate_heap (T *p, size_t n, bool mapped) const noexcept
+  {
+#if defined(__linux__)
+    if (mapped)
+    {
+      munmap (p, map_size (n * sizeof (T)));
+      return;
+    }
+#endif
+    if (use_malloc ())
+    {
+      std::free (p);
+      return;
+    }
+    std::destroy_n (p, n);
+    ::operator delete (p, std::align_val_t (block_alignment ()));
+  }
+
+/** * free_heap() - Frees the current heap block, with the deleter it
+      was adopted with if it was adopted.
+      Runtime complexity: O(capacity) for non-trivial T, O(1) otherwise.
+  */
+  void free_heap () noexcept
+  {
+    adopted_record *record = adopted ();
+    if (record != nullptr)
+    {
+      v_info = record->layout; // before the record is freed with the block
+      record->free_block (v_data, v_capacity, block_alignment (), record);
+    }
+    else
+    {
+      deallocate_heap (v_data, v_capacity, is_mapped ());
+      set_mapped (false);
+    }
+  }
+
+/** * heap_deleter() - A deleter that frees the current heap block the
+      way it was allocated (or adopted).
+      Runtime complexity: O(1).
+  */
+  vl_heap_deleter<T> heap_deleter () const noexcept
+  {
+    vl_heap_deleter<T> d;
+    d.capacity = v_capacity;
+    d.alignment = block_alignment ();
+    if (adopted_record *record = adopted ())
+    {
+      d.free_block = record->free_block;
+      d.context = record;
+    }
+#if defined(__linux__)
+    else if (is_mapped ())
+    {
+      d.free_block = &free_mapped_block;
+    }
+#endif
+    else if (use_malloc ())
+    {
+      d.free_block = &free_malloc_block;
+    }
+    else
+    {
+      d.free_block = &free_new_block;
+    }
+    return d;
+  }
+
+  static void free_malloc_block (T *p, size_t, size_t, void *) noexcept
+  {
+    std::free (p);
+  }
+
+  static void free_new_block (T *p, size_t capacity, size_t alignment,
+                              void *) noexcept
+  {
+    std::destroy_n (p, capacity);
+    ::operator delete (p, std::align_val_t (alignment));
+  }
+
+#if defined(__linux__)
+  static void free_mapped_block (T *p, size_t capacity, size_t,
+                                 void *) noexcept
+  {
+    munmap (p, map_size (capacity * sizeof (T)));
+  }
+#endif
+
+/** * free_adopted_block() - Calls the deleter a block was adopted with
+      (context is its adopted_deleter record), then frees the record.
+  */
+  template<class Deleter>
+  static void free_adopted_block (T *p, size_t, size_t, void *context)
+      noexcept
+  {
+    adopted_deleter<Deleter> *record = static_cast<adopted_deleter<Deleter> *> (
+        static_cast<adopted_record *> (context));
+    record->deleter (p);
+    delete record;
+  }
+
+/** * usable_capacity() - Number of elements that fit in the malloc
+      block p, which was requested for n elements.
+      Runtime complexity: O(1).
+  */
+  static size_t usable_capacity (void *p, size_t n) noexcept
+  {
+#if defined(__GLIBC__)
+    (void) n;
+    return malloc_usable_size (p) / sizeof (T);
+#else
+    (void) p;
+    return n;
+#endif
+  }
+
+#if defined(__linux__)
+/** * map_size() - Rounds a byte count up to whole pages.
+      Runtime complexity: O(1).
+  */
+  static size_t map_size (size_t bytes) noexcept
+  {
+    static const size_t page = (size_t) sysconf (_SC_PAGESIZE);
+    return (bytes + page - 1) / page * page;
+  }
+
+/** * map_pages() - Maps a private anonymous block of 'bytes' bytes
+      (a multiple of the page size) and asks for huge-page backing.
+      Runtime complexity: O(1).
+  */
+  static void *map_pages (size_t bytes)
+  {
+    void *p = mmap (nullptr, bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+      throw std::bad_alloc ();
+    }
+    madvise (p, bytes, MADV_HUGEPAGE);
+    return p;
+  }
+#endif
+
+/** * cap_c() - Calculates the new capacity of the vector based on
+      the current size and the number of elements to add.
+      The function uses a formula that approximates
+      the optimal capacity for the vector.
+      Runtime complexity: O(1).
+  */
+  size_t cap_c (size_t size, size_t k, size_t C)
+  {
+    if (size + k <= C)
+    {
+      // If sum of current size and k is <= to the static capacity C,
+      // return C indicating we still in static memory.
+      return C;
+    }
+    else
+    {
+      // If size + k exceeds C, calculate the dynamic memory capacity with
+      // a formula that approximates optimal: (size + k) * 3 / 2.
+      return ((size + k) * 3) / 2;
+    }
+  }
+};
+
+//<-------------------Static Capacity Vector--------------------->
+/**
+ * vl_vector - A vl_vector_ref that owns a stack buffer of static_capacity
+ * elements, aligned (together with its heap blocks) to 'alignment' bytes.
+ */
+template<typename T, size_t static_capacity = STATIC_CAPACITY,
+         size_t alignment = alignof (T)>
+class vl_vector : public vl_vector_ref<T>
+{
+  static_assert (alignment >= alignof (T),
+                 "alignment must be at least alignof(T)");
+  static_assert ((alignment & (alignment - 1)) == 0,
+                 "alignment must be a power of two");
+  static_assert (static_capacity <= (SIZE_MAX >> 8),
+                 "static capacity does not fit in the packed header");
+
+  // Mirrors the layout the base relies on in stack_data(): the stack
+  // buffer right after the header, at the next alignment boundary.
+  struct layout_check
+  {
+    alignas (vl_vector_ref<T>) char header[sizeof (vl_vector_ref<T>)];
+    alignas (alignment) char stack_buffer[sizeof (T)];
+  };
+  static_assert (offsetof (layout_check, stack_buffer)
+                 == (sizeof (vl_vector_ref<T>) + alignment - 1)
+                    / alignment * alignment,
+                 "the stack buffer must follow the vl_vector_ref header");
+ public:
+
+  //<--------Constructors---------->
+
+  /**  * Default constructor, new empty vector.
+         not using allocation memory on the heap.
+         Runtime complexity: O(1).
+   */
+
+  vl_vector () : vl_vector_ref<T> (static_capacity, alignment)
+  {
+  }
+
+/**  * Copy constructor.
+       Runtime complexity: O(n) - number of elements.
+ */
+
+  vl_vector (const vl_vector &other) : vl_vector ()
+  {
+    vl_vector_ref<T>::operator= (other);
+  }
+
+/**  * Copy constructor from a vector of any static capacity.
+       Runtime complexity: O(n) - number of elements.
+ */
+  explicit vl_vector (const vl_vector_ref<T> &other) : vl_vector ()
+  {
+    vl_vector_ref<T>::operator= (other);
+  }
+
+/**  * Sequence based constructor.
+       Runtime complexity: O(n)- num of elements in the range [first, last).
+ */
+  template<class ForwardIterator>
+  vl_vector (const ForwardIterator &first, const ForwardIterator &last)
+      : vl_vector ()
+  {
+    size_t range = std::distance (first, last);
+    if (range > static_capacity)
+    {
+      this->expand_capacity (range);
+    }
+    for (ForwardIterator it = first; it != last; ++it)
+    {
+      this->push_back (*it);
+    }
+  }
+
+/**  * Single-value initialized constructor.
+       The choice not to mark it as explicit is
+       to enhance code readability and ease of use.
+       Not leading to unexpected behavior, as it offers a unique signature
+       not found in other constructors.
+       Runtime complexity: O(count) - number of elements with value v.
+ */
+  vl_vector (size_t count, const T &v) : vl_vector ()
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      this->push_back (v);
+    }
+  }
+
+/**  * initializer_list Constructor.
+       convenient way to initialize the vector with a known set of values.
+       Runtime complexity: O(n) - number of elements in in_l.
+ */
+  vl_vector (std::initializer_list<T> in_l) : vl_vector ()
+  {
+    for (const T &value: in_l)  // iterates over elements in "in_l".
+    {
+      this->push_back (value);
+    }
+  }
+
+/**  * Constructor that takes over the elements of a std::vector (its
+       buffer as is when that is possible, see steal()).
+       Runtime complexity: O(1) when the buffer is taken over, else O(n).
+ */
+  template<class Allocator>
+  explicit vl_vector (std::vector<T, Allocator> &&other) : vl_vector ()
+  {
+    this->steal (std::move (other));
+  }
+
+/** * operator= - Copy assignment operator.
+      Runtime complexity: O(n).
+  */
+  vl_vector &operator= (const vl_vector &other) noexcept
+  {
+    vl_vector_ref<T>::operator= (other);
+    return *this;
+  }
+
+/** * operator= - Copy assignment from a vector of any static capacity.
+      Runtime complexity: O(n).
+  */
+  vl_vector &operator= (const vl_vector_ref<T> &other) noexcept
+  {
+    vl_vector_ref<T>::operator= (other);
+    return *this;
+  }
+
+/** * data() - Returns a direct pointer to the memory array
+      used by the vector now. (Stack or Heap)
+      The pointer is marked as aligned to 'alignment', so loops over it
+      can use aligned vector loads.
+      Runtime complexity: O(1).
+  */
+  T *data () noexcept
+  {
+    return assume_aligned (this->v_data);
+  }
+
+/** * data() - const version of the data() function.
+      Runtime complexity: O(1).
+  */
+  const T *data () const noexcept
+  {
+    return assume_aligned (this->v_data);
+  }
+
+ private:
+  // Stack array, the first member: vl_vector_ref finds it from 'this'.
+  alignas (alignment) T v_stack_buffer[static_capacity];
+
+/** * assume_aligned() - Tells the compiler that p is aligned to
+      'alignment'. Runtime complexity: O(1).
+  */
+  template<typename U>
+  static U *assume_aligned (U *p) noexcept
+  {
+#if defined(__cpp_lib_assume_aligned)
+    return std::assume_aligned<alignment> (p);
+#elif defined(__GNUC__) || defined(__clang__)
+    return static_cast<U *> (__builtin_assume_aligned (p, alignment));
+#else
+    return p;
+#endif
+  }
+};
+
+//<--------Byte Budget---------->
+/**
+ * vl_vector_bytes - A vl_vector whose static capacity is given as a byte
+ * budget: as many elements as fit in 'bytes' (at least one).
+ *   vl_vector_bytes<double, 64> v; // 8 doubles on the stack
+ */
+template<typename T, size_t bytes>
+using vl_vector_bytes =
+    vl_vector<T, (bytes / sizeof (T) > 0 ? bytes / sizeof (T) : 1)>;
+
+#if defined(VL_VECTOR_FD_IO)
+//<--------Scatter / Gather I/O---------->
+/** * writev_to_fd() - Writes the elements of every vector in the range
+      [first, last) (vl_vector_ref<T> or vl_vector<T, N>) to fd, in order,
+      from byte 'offset' of the whole range on, with writev(), IOV_MAX
+      vectors per call. Partial writes and EINTR are retried; like
+      write_to_fd(), it returns early instead of waiting for a full
+      non-blocking fd, to be called again with offset + the result.
+      return the number of bytes written by this call, or -1 with errno
+      set (EAGAIN included) if nothing could be written.
+      Runtime complexity: O(total number of elements).
+  */
+template<class ForwardIterator>
+ssize_t writev_to_fd (int fd, ForwardIterator first, ForwardIterator last,
+                      size_t offset = 0)
+{
+  using T = typename std::remove_pointer<decltype (first->data ())>::type;
+  static_assert (std::is_trivially_copyable<T>::value,
+                 "fd I/O needs a trivially copyable T");
+  vl_vector<iovec> iov;
+  for (ForwardIterator it = first; it != last; ++it)
+  {
+    size_t bytes = it->size () * sizeof (T);
+    if (offset >= bytes) // already written
+    {
+      offset -= bytes;
+      continue;
+    }
+    iov.push_back (iovec {(char *) it->data () + offset, bytes - offset});
+    offset = 0;
+  }
+  iovec *cur = iov.data ();
+  size_t count = iov.size ();
+  size_t total = 0;
+  while (count > 0)
+  {
+    ssize_t put = writev (fd, cur, (int) std::min (count, (size_t) IOV_MAX));
+    if (put < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return total > 0 ? (ssize_t) total : -1;
+    }
+    size_t done = (size_t) put;
+    total += done;
+    while (count > 0 && done >= cur->iov_len) // skip the finished buffers
+    {
+      done -= cur->iov_len;
+      ++cur;
+      --count;
+    }
+    if (count > 0) // the next buffer was written only in part
+    {
+      cur->iov_base = (char *) cur->iov_base + done;
+      cur->iov_len -= done;
+    }
+  }
+  return (ssize_t) total;
+}
+
+/** * readv_from_fd() - Reads from fd into the unused capacity of every
+      vector in the range [first, last), in order, with readv(), and
+      appends what was read to each of them (reserve() before).
+      Ranges of more than IOV_MAX vectors are read in batches; the next
+      batch is read only when the last one was filled and fd still has
+      data ready, so like read() it does not wait for more.
+      A trailing partial element is completed like in append_from_fd(),
+      and partial works the same way: the cut off element is kept after
+      the last element of the first vector with unused capacity.
+      return the number of bytes appended, 0 at end-of-file (or with no
+      unused capacity), or -1 with errno set if nothing was appended.
+      Runtime complexity: O(total number of bytes read).
+  */
+template<class ForwardIterator>
+ssize_t readv_from_fd (int fd, ForwardIterator first, ForwardIterator last,
+                       size_t *partial = nullptr)
+{
+  using T = typename std::remove_pointer<decltype (first->data ())>::type;
+  static_assert (std::is_trivially_copyable<T>::value,
+                 "fd I/O needs a trivially copyable T");
+  size_t held = partial != nullptr ? *partial : 0;
+  size_t held_at = SIZE_MAX; // the vector holding the cut off element
+  vl_vector<iovec> iov;
+  for (ForwardIterator it = first; it != last; ++it)
+  {
+    size_t spare = (it->capacity () - it->size ()) * sizeof (T);
+    char *tail = (char *) (it->data () + it->size ());
+    if (held > 0 && spare > 0 && held_at == SIZE_MAX)
+    {
+      held_at = iov.size ();
+      tail += held;
+      spare -= held;
+    }
+    iov.push_back (iovec {tail, spare});
+  }
+  if (held >= sizeof (T) || (held > 0 && held_at == SIZE_MAX))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+  ssize_t total = 0;
+  ForwardIterator it = first;
+  size_t i = 0;
+  while (i < iov.size ())
+  {
+    if (i > 0 && !vl_fd_readable (fd))
+    {
+      break; // the batches so far were filled, but no more data is ready
+    }
+    size_t end = i + std::min (iov.size () - i, (size_t) IOV_MAX);
+    ssize_t got;
+    do
+    {
+      got = readv (fd, iov.data () + i, (int) (end - i));
+    }
+    while (got < 0 && errno == EINTR);
+    if (got <= 0)
+    {
+      if (got == 0 && total == 0 && partial != nullptr)
+      {
+        *partial = 0; // dropped at end-of-file
+      }
+      return total > 0 ? total : got;
+    }
+    size_t left = (size_t) got;
+    for (; i < end; ++i, ++it)
+    {
+      size_t before = i == held_at ? held : 0;
+      size_t bytes = std::min (left, iov[i].iov_len);
+      left -= bytes;
+      if (bytes < iov[i].iov_len) // the read ended in this buffer
+      {
+        int error;
+        char *tail = (char *) iov[i].iov_base - before;
+        bytes = vl_fd_complete (fd, tail, before + bytes, sizeof (T), error);
+        ssize_t whole = vl_fd_whole (bytes, sizeof (T), error, partial);
+        if (whole < 0)
+        {
+          return total > 0 ? total : -1;
+        }
+        it->set_size (it->size () + (size_t) whole / sizeof (T));
+        return total + whole;
+      }
+      if (before > 0)
+      {
+        *partial = 0; // completed
+      }
+      it->set_size (it->size () + (before + bytes) / sizeof (T));
+      total += (ssize_t) (before + bytes);
+    }
+  }
+  return total;
+}
+#endif
+
+//<--------Hashing---------->
+/** * vl_wymum() - 64x64 -> 128 bit multiply, low half into a, high into b.
+  */
+inline void vl_wymum (uint64_t &a, uint64_t &b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = (__uint128_t) a * b;
+  a = (uint64_t) r;
+  b = (uint64_t) (r >> 64);
+#else
+  uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t) a, lb = (uint32_t) b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  a = lo;
+  b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/** * vl_wymix() - Multiplies a by b and folds the 128 bit product.
+  */
+inline uint64_t vl_wymix (uint64_t a, uint64_t b) noexcept
+{
+  vl_wymum (a, b);
+  return a ^ b;
+}
+
+inline uint64_t vl_wyr8 (const uint8_t *p) noexcept
+{
+  uint64_t v;
+  std::memcpy (&v, p, 8);
+  return v;
+}
+
+inline uint64_t vl_wyr4 (const uint8_t *p) noexcept
+{
+  uint32_t v;
+  std::memcpy (&v, p, 4);
+  return v;
+}
+
+/** * vl_hash_bytes() - wyhash (final v4) of len bytes at key.
+      Reads the input in 48 byte strides with three independent
+      multiply-mix lanes, and needs no branch per byte for short keys.
+      Runtime complexity: O(len).
+  */
+inline uint64_t vl_hash_bytes (const void *key, size_t len,
+                               uint64_t seed = 0) noexcept
+{
+  static const uint64_t secret[4] = {0x2d358dccaa6c78a5ull,
+                                     0x8bb84b93962eacc9ull,
+                                     0x4b33a62ed433d4a3ull,
+                                     0x4d5a2da51de1aa47ull};
+  const uint8_t *p = static_cast<const uint8_t *> (key);
+  seed ^= vl_wymix (seed ^ secret[0], secret[1]);
+  uint64_t a, b;
+  if (len <= 16)
+  {
+    if (len >= 4)
+    {
+      a = (vl_wyr4 (p) << 32) | vl_wyr4 (p + ((len >> 3) << 2));
+      b = (vl_wyr4 (p + len - 4) << 32)
+          | vl_wyr4 (p + len - 4 - ((len >> 3) << 2));
+    }
+    else if (len > 0)
+    {
+      a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+      b = 0;
+    }
+    else
+    {
+      a = b = 0;
+    }
+  }
+  else
+  {
+    size_t i = len;
+    if (i >= 48)
+    {
+      uint64_t see1 = seed, see2 = seed;
+      do
+      {
+        seed = vl_wymix (vl_wyr8 (p) ^ secret[1], vl_wyr8 (p + 8) ^ seed);
+        see1 = vl_wymix (vl_wyr8 (p + 16) ^ secret[2],
+                         vl_wyr8 (p + 24) ^ see1);
+        see2 = vl_wymix (vl_wyr8 (p + 32) ^ secret[3],
+                         vl_wyr8 (p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      }
+      while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16)
+    {
+      seed = vl_wymix (vl_wyr8 (p) ^ secret[1], vl_wyr8 (p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = vl_wyr8 (p + i - 16);
+    b = vl_wyr8 (p + i - 8);
+  }
+  a ^= secret[1];
+  b ^= seed;
+  vl_wymum (a, b);
+  return vl_wymix (a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+/** * vl_hash_range() - Hash of the n elements at p. Elements with unique
+      object representations are hashed as one block of bytes, others
+      by mixing std::hash<T> of each element.
+      Runtime complexity: O(n).
+  */
+template<typename T>
+size_t vl_hash_range (const T *p, size_t n) noexcept
+{
+  if constexpr (std::has_unique_object_representations<T>::value)
+  {
+    return (size_t) vl_hash_bytes (p, n * sizeof (T));
+  }
+  else
+  {
+    uint64_t h = vl_wymix (n, 0x8bb84b93962eacc9ull);
+    for (size_t i = 0; i < n; ++i)
+    {
+      h = vl_wymix (h ^ (uint64_t) std::hash<T> () (p[i]),
+                    0x4d5a2da51de1aa47ull);
+    }
+    return (size_t) h;
+  }
+}
+
+/**
+ * vl_vector_hash - Transparent hash for vl_vector keys: a vl_vector of
+ * any static capacity, a std::basic_string_view<T> or (C++20) a
+ * std::span<const T> with the same elements hash the same.
+ */
+template<typename T>
+struct vl_vector_hash
+{
+  using is_transparent = void;
+
+  size_t operator() (const vl_vector_ref<T> &v) const noexcept
+  {
+    return vl_hash_range (v.data (), v.size ());
+  }
+
+  template<typename C, typename = std::enable_if_t<std::is_same<C, T>::value>>
+  size_t operator() (std::basic_string_view<C> s) const noexcept
+  {
+    return vl_hash_range (s.data (), s.size ());
+  }
+
+#if defined(__cpp_lib_span)
+  size_t operator() (std::span<const T> s) const noexcept
+  {
+    return vl_hash_range (s.data (), s.size ());
+  }
+#endif
+};
+
+/**
+ * vl_vector_equal - Transparent equality matching vl_vector_hash:
+ * compares the elements of any two of the key types it hashes.
+ */
+template<typename T>
+struct vl_vector_equal
+{
+  using is_transparent = void;
+
+  template<typename A, typename B>
+  bool operator() (const A &a, const B &b) const
+  {
+    return a.size () == b.size ()
+           && std::equal (a.data (), a.data () + a.size (), b.data ());
+  }
+};
+
+/**
+ * std::hash specialization, so vl_vectors can be used directly as keys
+ * of std::unordered_map / std::unordered_set.
+ */
+template<typename T, size_t static_capacity, size_t alignment>
+struct std::hash<vl_vector<T, static_capacity, alignment>> : vl_vector_hash<T>
+{
 };
 
 #endif //_VL_VECTOR_HPP_
@@ -0,0 +1,327 @@
+//<-----------------Description Section----------------------->
+// This header contains vl_vector_snapshot, a holder for a read-mostly
+// vl_vector shared between threads (RCU style). A writer builds a new
+// vector off to the side and publishes it with one atomic pointer swap.
+// Readers get a const view of the current vector without taking a lock
+// and without touching a shared reference count: the read path is
+// wait-free, and it does not slow down while a writer publishes.
+
+//--------Epoch Based Reclamation-----------//
+// A replaced vector cannot be deleted while a reader may still hold it.
+// Every reader thread owns a slot (on its own cache line) in a process
+// wide table. Before loading the pointer, a reader stores the current
+// global epoch in its slot, and clears the slot when it is done.
+// On publish, the writer swaps the pointer, advances the epoch to E, and
+// retires the old vector with E. A retired vector is deleted once every
+// slot is clear or holds an epoch >= E: those readers loaded the pointer
+// after the swap, so none of them can see the old vector.
+
+//--------Limits-----------//
+// At most VL_SNAPSHOT_MAX_READERS threads can read at the same time
+// (slots are given back when a thread exits). Writers (publish, update,
+// reclaim) are serialized by a mutex, since they are rare and off the
+// hot path. update() holds it while it copies, so its copy source cannot
+// be retired under it.
+
+#ifndef _VL_VECTOR_SNAPSHOT_HPP_
+#define _VL_VECTOR_SNAPSHOT_HPP_
+
+//<------------------DEFINE & INCLUDES--------------------->
+#ifndef VL_SNAPSHOT_MAX_READERS // reader threads with a slot at a time
+#define VL_SNAPSHOT_MAX_READERS 128
+#endif
+
+#include "vl_vector.hpp"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+//<-----------------------IMPLEMENTATION----------------------->
+
+/**
+ * vl_epoch_domain - The global epoch and the reader slots, shared by all
+ * the snapshots of the process.
+ */
+struct vl_epoch_domain
+{
+  struct alignas (VL_CACHE_LINE_SIZE) slot
+  {
+    std::atomic<uint64_t> pinned {0}; // epoch seen by the reader, 0 if idle
+    std::atomic<bool> used {false}; // owned by a thread
+  };
+
+  alignas (VL_CACHE_LINE_SIZE) std::atomic<uint64_t> epoch {1};
+  slot slots[VL_SNAPSHOT_MAX_READERS];
+
+/** * instance() - The process wide domain.
+  */
+  static vl_epoch_domain &instance () noexcept
+  {
+    static vl_epoch_domain domain;
+    return domain;
+  }
+
+/** * min_pinned() - Smallest epoch pinned by a reader, or the largest
+      uint64_t if no reader is inside a read section.
+      Runtime complexity: O(VL_SNAPSHOT_MAX_READERS).
+  */
+  uint64_t min_pinned () const noexcept
+  {
+    uint64_t min = std::numeric_limits<uint64_t>::max ();
+    for (const slot &s: slots)
+    {
+      uint64_t e = s.pinned.load (std::memory_order_seq_cst);
+      if (e != 0 && e < min)
+      {
+        min = e;
+      }
+    }
+    return min;
+  }
+};
+
+/**
+ * vl_epoch_reader - The slot of the calling thread, taken on its first
+ * read and given back when the thread exits. Read sections may nest.
+ */
+class vl_epoch_reader
+{
+ public:
+/** * current() - The reader of the calling thread.
+      exception if all VL_SNAPSHOT_MAX_READERS slots are taken.
+  */
+  static vl_epoch_reader &current ()
+  {
+    static thread_local vl_epoch_reader reader;
+    return reader;
+  }
+
+/** * pin() - Enters a read section: publishes the current epoch in the
+      slot before the caller loads any snapshot pointer.
+      Runtime complexity: O(1), wait-free.
+  */
+  void pin () noexcept
+  {
+    if (r_depth++ == 0)
+    {
+      vl_epoch_domain &domain = vl_epoch_domain::instance ();
+      r_slot->pinned.store (domain.epoch.load (std::memory_order_seq_cst),
+                            std::memory_order_seq_cst);
+    }
+  }
+
+/** * unpin() - Leaves a read section.
+      Runtime complexity: O(1), wait-free.
+  */
+  void unpin () noexcept
+  {
+    if (--r_depth == 0)
+    {
+      r_slot->pinned.store (0, std::memory_order_release);
+    }
+  }
+
+  vl_epoch_reader (const vl_epoch_reader &) = delete;
+  vl_epoch_reader &operator= (const vl_epoch_reader &) = delete;
+
+ private:
+  vl_epoch_reader ()
+  {
+    for (vl_epoch_domain::slot &s: vl_epoch_domain::instance ().slots)
+    {
+      bool expected = false;
+      if (!s.used.load (std::memory_order_relaxed)
+          && s.used.compare_exchange_strong (expected, true))
+      {
+        r_slot = &s;
+        return;
+      }
+    }
+    throw std::length_error ("more than VL_SNAPSHOT_MAX_READERS readers");
+  }
+
+  ~vl_epoch_reader ()
+  {
+    r_slot->pinned.store (0, std::memory_order_release);
+    r_slot->used.store (false, std::memory_order_release);
+  }
+
+  vl_epoch_domain::slot *r_slot = nullptr;
+  unsigned r_depth = 0;
+};
+
+/**
+ * vl_vector_snapshot - Publishes immutable versions of a vl_vector<T, N>
+ * to any number of reader threads.
+ */
+template<typename T, size_t static_capacity = STATIC_CAPACITY>
+class vl_vector_snapshot
+{
+ public:
+  using vector_type = vl_vector<T, static_capacity>;
+
+/**
+ * read_guard - A read section: the vector it points to stays alive and
+ * unchanged until the guard is destroyed. Keep it short-lived, a long
+ * read section delays the deletion of the replaced versions.
+ */
+  class read_guard
+  {
+   public:
+    const vector_type &operator* () const noexcept { return *g_vec; }
+    const vector_type *operator-> () const noexcept { return g_vec; }
+    const vector_type *get () const noexcept { return g_vec; }
+
+    read_guard (const read_guard &) = delete;
+    read_guard &operator= (const read_guard &) = delete;
+
+    ~read_guard ()
+    {
+      g_reader.unpin ();
+    }
+
+   private:
+    friend class vl_vector_snapshot;
+
+    read_guard (const std::atomic<vector_type *> &current)
+        : g_reader (vl_epoch_reader::current ())
+    {
+      g_reader.pin ();
+      g_vec = current.load (std::memory_order_seq_cst);
+    }
+
+    vl_epoch_reader &g_reader;
+    const vector_type *g_vec;
+  };
+
+  //<--------Constructors and Destructor---------->
+
+/**  * Constructor, publishes an empty vector.
+ */
+  vl_vector_snapshot () : s_current (new vector_type ())
+  {
+  }
+
+/**  * Constructor, publishes a copy of v.
+       Runtime complexity: O(n).
+ */
+  explicit vl_vector_snapshot (const vl_vector_ref<T> &v)
+      : s_current (new vector_type (v))
+  {
+  }
+
+  vl_vector_snapshot (const vl_vector_snapshot &) = delete;
+  vl_vector_snapshot &operator= (const vl_vector_snapshot &) = delete;
+
+/**  * Destructor. No reader may still be inside a read section.
+ */
+  ~vl_vector_snapshot ()
+  {
+    delete s_current.load ();
+    for (const retired &r: s_retired)
+    {
+      delete r.vec;
+    }
+  }
+
+//<--------Reading---------->
+
+/** * read() - Returns a guard to the current vector.
+      Runtime complexity: O(1), wait-free, no shared writes.
+  */
+  read_guard read () const
+  {
+    return read_guard (s_current);
+  }
+
+//<--------Writing---------->
+
+/** * publish() - Makes v the current vector (readers that already hold
+      the previous one keep it), then deletes the old versions that no
+      reader can see anymore.
+      Runtime complexity: O(VL_SNAPSHOT_MAX_READERS + retired versions).
+  */
+  void publish (std::unique_ptr<vector_type> v)
+  {
+    std::lock_guard<std::mutex> lock (s_writer);
+    publish_locked (std::move (v));
+  }
+
+/** * publish() - Publishes a copy of v.
+      Runtime complexity: O(n).
+  */
+  void publish (const vl_vector_ref<T> &v)
+  {
+    publish (std::unique_ptr<vector_type> (new vector_type (v)));
+  }
+
+/** * update() - Copies the current vector, applies fn to the copy and
+      publishes it, as one step with respect to the other writers: no
+      publish() or update() can come in between. fn must not call
+      publish() or update() on this snapshot.
+      Runtime complexity: O(n) + fn.
+  */
+  template<class Function>
+  void update (Function fn)
+  {
+    std::lock_guard<std::mutex> lock (s_writer);
+    std::unique_ptr<vector_type> next (new vector_type (*s_current.load ()));
+    fn (*next);
+    publish_locked (std::move (next));
+  }
+
+/** * reclaim() - Deletes the replaced versions no reader can see anymore.
+      publish() calls it, call it after the last publish to free the rest.
+      Runtime complexity: O(VL_SNAPSHOT_MAX_READERS + retired versions).
+  */
+  void reclaim ()
+  {
+    std::lock_guard<std::mutex> lock (s_writer);
+    reclaim_locked ();
+  }
+
+ private:
+  struct retired
+  {
+    vector_type *vec;
+    uint64_t epoch; // first epoch in which no reader can load vec
+  };
+
+  void publish_locked (std::unique_ptr<vector_type> v)
+  {
+    vector_type *old = s_current.exchange (v.release (),
+                                           std::memory_order_seq_cst);
+    vl_epoch_domain &domain = vl_epoch_domain::instance ();
+    uint64_t epoch = domain.epoch.fetch_add (1, std::memory_order_seq_cst);
+    s_retired.push_back (retired {old, epoch + 1});
+    reclaim_locked ();
+  }
+
+  void reclaim_locked ()
+  {
+    uint64_t min = vl_epoch_domain::instance ().min_pinned ();
+    size_t kept = 0;
+    for (size_t i = 0; i < s_retired.size (); ++i)
+    {
+      if (s_retired[i].epoch <= min)
+      {
+        delete s_retired[i].vec;
+      }
+      else
+      {
+        s_retired[kept++] = s_retired[i];
+      }
+    }
+    while (s_retired.size () > kept)
+    {
+      s_retired.pop_back ();
+    }
+  }
+
+  std::atomic<vector_type *> s_current;
+  vl_vector<retired> s_retired; // replaced versions, oldest first
+  std::mutex s_writer; // guards s_current swaps and s_retired
+};
+
+#endif //_VL_VECTOR_SNAPSHOT_HPP_